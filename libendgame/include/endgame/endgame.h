@@ -13,6 +13,9 @@
 #include <endgame/event.h>
 #include <endgame/input.h>
 #include <endgame/io.h>
+#include <endgame/label.h>
 #include <endgame/output.h>
+#include <endgame/panel.h>
 #include <endgame/scene.h>
 #include <endgame/sprite.h>
+#include <endgame/viewport.h>
@@ -22,12 +22,13 @@ typedef enum {
   EG_EVENT_KEYPRESS,
   EG_EVENT_TICK, ///< a game tick
   EG_EVENT_SIGNAL,
+  EG_EVENT_TIMER, ///< expiry of a timer from `eg_io_add_timer`
 } eg_event_type_t;
 
 /// return type of `eg_input_read`
 typedef struct {
   eg_event_type_t type; ///< was this event a key, signal, or error?
-  uint32_t value;       ///< payload (key, signal number, or errno)
+  uint32_t value;       ///< payload (key, signal number, timer tag, or errno)
 } eg_event_t;
 
 #ifdef __cplusplus
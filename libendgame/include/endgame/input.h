@@ -1,6 +1,7 @@
 #pragma once
 
 #include <endgame/event.h>
+#include <stdbool.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -30,6 +31,20 @@ typedef struct eg_input eg_input_t;
 /// \return 0 on success or an errno on failure.
 ENDGAME_API int eg_input_new(eg_input_t **me, FILE *in);
 
+/// setup an input device that replays a recorded session
+///
+/// Events are read from a log previously written by `eg_io_record`, instead of
+/// from a TTY. The log stream remains owned by the caller and must outlive the
+/// input device.
+///
+/// \param me [out] Created input device on success
+/// \param log Stream to read the event log from
+/// \param realtime If true, wait between events as long as was originally
+///   recorded, otherwise return events as fast as they are requested
+/// \return 0 on success, `EBADMSG` if `log` is not an event log, or another
+///   errno on failure
+ENDGAME_API int eg_input_replay_new(eg_input_t **me, FILE *log, bool realtime);
+
 /// get a new event
 ///
 /// This function blocks until there is a key press or a signal is received, or
@@ -44,6 +59,10 @@ ENDGAME_API int eg_input_new(eg_input_t **me, FILE *in);
 ///      happen when the user presses keys. That is, `eg_screen_read` blocks
 ///      indefinitely until a key is pressed.
 ///
+/// A replaying input device ignores `tick` and returns recorded events, ticks
+/// included, in their original order. Once the log is exhausted, it returns an
+/// `EG_EVENT_ERROR` event with value `ENODATA`.
+///
 /// \param me Input device to read from
 /// \param tick Timeout (ms) after which a tick is considered to have happened
 /// \return Event seen
@@ -3,7 +3,9 @@
 #include <endgame/event.h>
 #include <endgame/input.h>
 #include <endgame/output.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -55,6 +57,25 @@ ENDGAME_API size_t eg_io_get_columns(const eg_io_t *me);
 /// get the number of rows in the terminal
 ENDGAME_API size_t eg_io_get_rows(const eg_io_t *me);
 
+/// query the terminal for its capabilities
+///
+/// See `eg_output_probe`. The terminal’s replies are read from this device’s
+/// input, and any key presses that arrive interleaved with them are returned by
+/// subsequent reads.
+///
+/// \param me I/O device to probe
+/// \param timeout Milliseconds to wait for replies
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_probe(eg_io_t *me, int timeout);
+
+/// get the capabilities of the terminal, as of the last probe
+///
+/// \param me I/O device to query
+/// \param caps [out] Capabilities of the terminal
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_get_capabilities(const eg_io_t *me,
+                                       eg_capabilities_t *caps);
+
 /// write some text to the I/O device
 ///
 /// \param me I/O device to write to
@@ -92,6 +113,59 @@ ENDGAME_API int eg_io_print(eg_io_t *me, size_t x, size_t y, const char *format,
 /// \return 0 on success or an errno on failure
 ENDGAME_API int eg_io_sync(eg_io_t *me);
 
+/// is the I/O device keeping up with output?
+///
+/// See `eg_output_should_render`.
+///
+/// \param me I/O device to query
+/// \return True if a new frame would be written promptly
+ENDGAME_API bool eg_io_should_render(eg_io_t *me);
+
+/// enable or disable automatic frame skipping for the I/O device
+///
+/// See `eg_output_set_frame_skip`.
+///
+/// \param me I/O device to configure
+/// \param skip Whether to skip frames when the terminal is behind
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_set_frame_skip(eg_io_t *me, bool skip);
+
+/// retrieve output statistics for the I/O device
+///
+/// \param me I/O device to query
+/// \param stats [out] Current statistics
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_get_output_stats(eg_io_t *me, eg_output_stats_t *stats);
+
+/// start or stop capturing output from the I/O device
+///
+/// See `eg_output_capture`.
+///
+/// \param me I/O device to capture
+/// \param file Stream to save to, or `NULL` to stop capturing
+/// \param format How to save output
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_capture(eg_io_t *me, FILE *file,
+                              eg_capture_format_t format);
+
+/// enable or disable synchronized output for the I/O device
+///
+/// See `eg_output_set_synchronized`.
+///
+/// \param me I/O device to configure
+/// \param synchronized Whether to use synchronized output
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_set_synchronized(eg_io_t *me, bool synchronized);
+
+/// enable or disable asynchronous output for the I/O device
+///
+/// See `eg_output_set_async`.
+///
+/// \param me I/O device to configure
+/// \param async Whether to write asynchronously
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_set_async(eg_io_t *me, bool async);
+
 /// set the game “tick” for this device
 ///
 /// The game “tick” is a timeout in ms after which a tick is considered to have
@@ -110,17 +184,139 @@ ENDGAME_API int eg_io_sync(eg_io_t *me);
 /// \return 0 on success or an errno on failure
 ENDGAME_API int eg_io_set_tick(eg_io_t *me, int tick);
 
+/// suspend or resume the game tick
+///
+/// While idle, e.g. in a paused menu with nothing animating, `eg_io_read`
+/// returns no ticks. It sleeps until a key is pressed, a timer expires or a
+/// signal is received, instead of waking every tick. A key press ends idling,
+/// so ticks resume from the next read onwards. Timers are delivered as usual
+/// while idle, without ending it.
+///
+/// \param me I/O device to update
+/// \param idle Whether to suspend the tick
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_set_idle(eg_io_t *me, bool idle);
+
+/// identifier of a timer scheduled with `eg_io_add_timer`
+///
+/// 0 is never used, so can be used to mean “no timer.”
+typedef uint64_t eg_timer_handle_t;
+
+/// schedule a timer
+///
+/// When the timer expires, `eg_io_read` returns an `EG_EVENT_TIMER` event whose
+/// value is `tag`. Timers are independent of each other and of the game tick,
+/// so e.g. each entity in a game can have its own cooldown. Scheduling,
+/// cancelling and expiring a timer each take constant time, regardless of how
+/// many timers are pending.
+///
+/// A periodic timer that expires several times before it is read is delivered
+/// once, and keeps its phase.
+///
+/// While replaying a recording, timer events come from the recording rather
+/// than from timers expiring.
+///
+/// \param me I/O device to deliver the timer’s events
+/// \param delay Milliseconds from now until the timer expires
+/// \param period Milliseconds between subsequent expiries, or 0 for a one-shot
+///   timer
+/// \param tag Value to deliver with the timer’s events
+/// \param handle [out] Identifier of the timer on success, for cancelling it.
+///   This may be `NULL` if not needed.
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_add_timer(eg_io_t *me, uint32_t delay, uint32_t period,
+                                uint32_t tag, eg_timer_handle_t *handle);
+
+/// unschedule a timer
+///
+/// An expired timer whose event has not yet been read is discarded.
+///
+/// \param me I/O device the timer was added to
+/// \param handle Identifier from `eg_io_add_timer`
+/// \return 0 on success, `ENOENT` if the timer is no longer scheduled, or
+///   another errno on failure
+ENDGAME_API int eg_io_cancel_timer(eg_io_t *me, eg_timer_handle_t handle);
+
+/// start or stop recording events
+///
+/// While recording, every event returned by `eg_io_read` is appended to `log`
+/// along with the time elapsed since the previous one, in a compact binary
+/// format. The resulting log can be played back with `eg_input_replay_new`.
+/// The log stream remains owned by the caller, who is responsible for flushing
+/// and closing it after recording stops. Recording can resume onto a log that
+/// already holds events, whether by restarting on the same stream or appending
+/// to an existing file or pipe, and it replays as one continuous session.
+///
+/// \param me I/O device to record
+/// \param log Stream to record to, or `NULL` to stop recording
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_record(eg_io_t *me, FILE *log);
+
 /// get a new event
 ///
-/// This function blocks until there is a key press or a signal is received, or
-/// an error occurs. Control characters and chords are returned as they are seen
-/// by reading stdin. This means e.g. Ctrl-D comes out as 0x4. Non-ASCII UTF-8
-/// characters are also readable naturally this way.
+/// This function blocks until there is a key press, a tick, a timer expires or
+/// a signal is received, or an error occurs. Control characters and chords are
+/// returned as they are seen by reading stdin. This means e.g. Ctrl-D comes out
+/// as 0x4. Non-ASCII UTF-8 characters are also readable naturally this way.
 ///
 /// \param me I/O device to read from
 /// \return Event seen
 ENDGAME_API eg_event_t eg_io_read(eg_io_t *me);
 
+/// get a new event, if one is ready
+///
+/// This is a non-blocking version of `eg_io_read`, for driving an I/O device
+/// from an external event loop. Rather than waiting, such a loop watches the
+/// descriptors from `eg_io_get_fds` for readability, with a timeout from
+/// `eg_io_get_timeout`. When either fires, it calls this until it returns
+/// `EAGAIN`. Ticks and timers are generated as they would be by `eg_io_read`.
+///
+/// \param me I/O device to read from
+/// \return Event seen, or an `EG_EVENT_ERROR` event with value `EAGAIN` if
+///   there was none ready
+ENDGAME_API eg_event_t eg_io_poll(eg_io_t *me);
+
+/// find which file descriptors an external event loop should watch
+///
+/// When any of these become readable, `eg_io_poll` will have an event to
+/// return.
+///
+/// \param me I/O device to query
+/// \param fds [out] Storage for up to `capacity` descriptors
+/// \param capacity Number of entries available in `fds`
+/// \param n [out] Number of descriptors to watch, which may exceed `capacity`
+///   in which case only the first `capacity` are written to `fds`
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_get_fds(const eg_io_t *me, int *fds, size_t capacity,
+                              size_t *n);
+
+/// find how long an external event loop may wait before calling `eg_io_poll`
+///
+/// This is the time until the next tick or timer is due, assuming no input
+/// arrives in the meantime. It changes when the tick is set or a timer is
+/// added, so should be retrieved again after doing either. While replaying a
+/// session in real time, it is the time until the next recorded event.
+///
+/// \param me I/O device to query
+/// \param timeout [out] Milliseconds until the next deadline, 0 if an event
+///   is already due, or -1 if there is no deadline
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_get_timeout(eg_io_t *me, int *timeout);
+
+/// counts of how often `eg_io_read` has woken up, and why
+typedef struct {
+  uint64_t wakeups; ///< number of times waiting for an event has ended
+  uint64_t ticks;   ///< number of tick events returned
+  uint64_t timers;  ///< number of timer events returned
+} eg_io_stats_t;
+
+/// retrieve statistics about events read
+///
+/// \param me I/O device to query
+/// \param stats [out] Current statistics
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_io_get_stats(eg_io_t *me, eg_io_stats_t *stats);
+
 /// blank the screen, clearing all text
 ///
 /// \param me I/O device to clear
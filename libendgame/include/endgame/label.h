@@ -0,0 +1,76 @@
+#pragma once
+
+#include <endgame/io.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ENDGAME_API
+#ifdef __GNUC__
+#define ENDGAME_API __attribute__((visibility("default")))
+#elif defined(_MSC_VER)
+#define ENDGAME_API __declspec(dllexport)
+#else
+#define ENDGAME_API // nothing
+#endif
+#endif
+
+/// a line of text displayed at a fixed position on an I/O device
+///
+/// A label remembers the text it last displayed. Setting it to the same text
+/// again writes nothing, so a score or status line can be set every frame and
+/// only costs output when its value actually changes. When the text changes to
+/// something narrower, the columns it no longer covers are blanked.
+///
+/// Like a viewport, a label assumes it has sole ownership of its area of the
+/// I/O device. If anything else draws over it (including `eg_io_clear`), call
+/// `eg_label_invalidate` so the next update redraws it.
+typedef struct eg_label eg_label_t;
+
+/// create a label
+///
+/// The label refers to, but does not take ownership of, `io`, which must
+/// outlive the label. Nothing is displayed until the label is first set.
+///
+/// \param me [out] Created label on success
+/// \param io Device to draw onto
+/// \param x Column at which the label begins
+/// \param y Row at which the label begins
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_label_new(eg_label_t **me, eg_io_t *io, size_t x, size_t y);
+
+/// change the text of a label
+///
+/// \param me Label to update
+/// \param text Null terminated text to display, which may contain escape
+///   sequences
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_label_set(eg_label_t *me, const char *text);
+
+/// change the text of a label to `printf`-style arguments
+///
+/// \param me Label to update
+/// \param format A `printf`-style format string
+/// \param ... `printf`-style format arguments
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_label_print(eg_label_t *me, const char *format, ...);
+
+/// discard a label’s record of what it last displayed
+///
+/// The next call to `eg_label_set` or `eg_label_print` will write the label
+/// even if its text is unchanged.
+///
+/// \param me Label to invalidate
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_label_invalidate(eg_label_t *me);
+
+/// destroy a label
+///
+/// This does not erase the label from the I/O device.
+ENDGAME_API void eg_label_free(eg_label_t **me);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -21,24 +23,113 @@ extern "C" {
 /// handle to a TTY-backed terminal output stream for display
 typedef struct eg_output eg_output_t;
 
+/// measurements of how well the terminal is keeping up with output
+typedef struct {
+  uint64_t frames;   ///< number of frames written to the terminal
+  uint64_t skipped;  ///< number of syncs whose frame was never written
+  uint64_t bytes;    ///< total bytes written for frames
+  uint64_t flush_ns; ///< time taken to write the most recent frame
+  size_t queued;     ///< bytes written but not yet sent on by the terminal
+} eg_output_stats_t;
+
+/// features of the terminal, as determined by probing it
+typedef struct {
+  bool synchronized;    ///< supports synchronized output (DEC mode 2026)?
+  bool sgr_mouse;       ///< supports SGR mouse reporting (DEC mode 1006)?
+  bool truecolor;       ///< advertises 24-bit colour via `$COLORTERM`?
+  bool rep;             ///< supports REP, repeating the preceding character?
+  bool ech;             ///< supports ECH, erasing characters?
+  unsigned conformance; ///< DA1 conformance level (e.g. 62 for VT220), or 0
+  unsigned model;       ///< DA2 terminal type, or 0
+  unsigned firmware;    ///< DA2 firmware version, or 0
+  char version[64];     ///< XTVERSION name and version, or empty
+} eg_capabilities_t;
+
+/// file formats for capturing output
+typedef enum {
+  /// the bytes written to the terminal, verbatim, with each frame followed by
+  /// the Application Program Command `\033_endgame:frame\033\\`
+  EG_CAPTURE_RAW,
+
+  /// an asciinema asciicast v2 recording, with each frame followed by a marker
+  EG_CAPTURE_ASCIICAST,
+} eg_capture_format_t;
+
 /// setup the terminal for Curses-style output
 ///
 /// This function must be called before using any of the other functions in this
 /// header.
 ///
+/// The terminal is probed for its capabilities (see `eg_output_probe`), and
+/// output is tailored to what it supports. For example, if the terminal
+/// supports synchronized output it is used for every frame. See
+/// `eg_output_set_synchronized`.
+///
 /// \param me [out] Created output on success
 /// \param out Stream for this output
 /// \return 0 on success or an errno on failure.
 ENDGAME_API int eg_output_new(eg_output_t **me, FILE *out);
 
+/// create an output that is not connected to a terminal
+///
+/// A headless output behaves like any other, except that nothing is written
+/// anywhere. This is useful for exercising a game without a terminal, e.g. to
+/// benchmark a replayed session (see `eg_input_replay_new`). Debug messages are
+/// discarded.
+///
+/// \param me [out] Created output on success
+/// \param columns Width of the simulated terminal
+/// \param rows Height of the simulated terminal
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_output_new_headless(eg_output_t **me, size_t columns,
+                                       size_t rows);
+
 /// get the number of columns in the terminal
 ENDGAME_API size_t eg_output_get_columns(const eg_output_t *me);
 
 /// get the number of rows in the terminal
 ENDGAME_API size_t eg_output_get_rows(const eg_output_t *me);
 
+/// query the terminal for its capabilities
+///
+/// This is done automatically by `eg_output_new` with a timeout of 100ms, or
+/// the number of milliseconds in `$ENDGAME_PROBE_TIMEOUT` if set, and only
+/// needs to be repeated if the terminal may have changed or a previous probe
+/// may have timed out. Probing waits for the terminal to reply to a sequence of
+/// queries, or `timeout` to pass. Terminals generally reply in well under a
+/// millisecond, but the round trip over a remote connection can take much
+/// longer. The screen is redrawn in full on the next sync.
+///
+/// Features not reported by the probe are not used, so a timeout results in
+/// more conservative output. When the output belongs to an I/O device,
+/// replies that arrive after a timeout are discarded rather than mistaken for
+/// key presses. Synchronized output is turned off if the terminal no longer
+/// reports it, but is never turned back on by a probe. Use
+/// `eg_output_set_synchronized` to enable it after a successful re-probe.
+///
+/// The terminal’s replies are read from the controlling terminal, so anything
+/// else typed while probing is discarded. Probe through `eg_io_probe` instead
+/// to have it returned as input.
+///
+/// \param me Output to probe
+/// \param timeout Milliseconds to wait for replies
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_output_probe(eg_output_t *me, int timeout);
+
+/// get the capabilities of the terminal, as of the last probe
+///
+/// \param me Output to query
+/// \param caps [out] Capabilities of the terminal
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_output_get_capabilities(const eg_output_t *me,
+                                           eg_capabilities_t *caps);
+
 /// write some text to the output
 ///
+/// Text is written to an off-screen frame and does not appear on the terminal
+/// until the next call to `eg_output_sync`. Text that extends beyond the right
+/// edge of the terminal is discarded.
+///
 /// \param me Output to write to
 /// \param x Column at which to begin the write
 /// \param y Row at which to begin the write
@@ -60,12 +151,86 @@ ENDGAME_API int eg_output_puts(eg_output_t *me, size_t x, size_t y,
 
 /// flush pending writes to the output
 ///
+/// Only the cells that differ from what is currently displayed are written to
+/// the terminal. If asynchronous output is enabled, the frame is handed to the
+/// writer thread instead and this does not wait for it to be written. A failure
+/// writing a previous frame is reported by the next call.
+///
 /// \param me Output to synchronise
 /// \return 0 on success or an errno on failure
 ENDGAME_API int eg_output_sync(eg_output_t *me);
 
+/// enable or disable synchronized output
+///
+/// When enabled, each frame written by `eg_output_sync` is bracketed with the
+/// synchronized update sequences of DEC mode 2026. Supporting terminals then
+/// render the frame once it is complete, instead of as it arrives.
+///
+/// \param me Output to configure
+/// \param synchronized Whether to use synchronized output
+/// \return 0 on success, `ENOTSUP` if the terminal did not report support for
+///   synchronized output, or another errno on failure
+ENDGAME_API int eg_output_set_synchronized(eg_output_t *me, bool synchronized);
+
+/// start or stop capturing output
+///
+/// While capturing, every byte written to the terminal is also written to
+/// `file`, with the end of each frame written by `eg_output_sync` marked.
+/// Output written before capturing began is not included. The stream remains
+/// owned by the caller, who is responsible for closing it after capturing
+/// stops.
+///
+/// \param me Output to capture
+/// \param file Stream to save to, or `NULL` to stop capturing
+/// \param format How to save output
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_output_capture(eg_output_t *me, FILE *file,
+                                  eg_capture_format_t format);
+
+/// enable or disable asynchronous output
+///
+/// When enabled, writing to the terminal happens on a background thread so a
+/// slow terminal does not stall the caller in `eg_output_sync`. If the writer
+/// falls behind, frames it has not yet started are dropped in favour of the
+/// latest one. Output is initially synchronous.
+///
+/// \param me Output to configure
+/// \param async Whether to write asynchronously
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_output_set_async(eg_output_t *me, bool async);
+
+/// is the terminal keeping up with output?
+///
+/// This returns false when previous frames are still queued on their way to
+/// the terminal, in which case a caller may save itself the effort of drawing
+/// the current frame. Changes made with `eg_output_put` are not lost by
+/// skipping a sync; they are written along with the next frame.
+///
+/// \param me Output to query
+/// \return True if a new frame would be written promptly
+ENDGAME_API bool eg_output_should_render(eg_output_t *me);
+
+/// enable or disable automatic frame skipping
+///
+/// When enabled, `eg_output_sync` does nothing while `eg_output_should_render`
+/// would return false. Frame skipping is initially disabled.
+///
+/// \param me Output to configure
+/// \param skip Whether to skip frames when the terminal is behind
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_output_set_frame_skip(eg_output_t *me, bool skip);
+
+/// retrieve output statistics
+///
+/// \param me Output to query
+/// \param stats [out] Current statistics
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_output_get_stats(eg_output_t *me, eg_output_stats_t *stats);
+
 /// blank the output, clearing all text
 ///
+/// Like `eg_output_put`, this takes effect at the next `eg_output_sync`.
+///
 /// \param me Output to clear
 /// \return 0 on success or an errno on failure
 ENDGAME_API int eg_output_clear(eg_output_t *me);
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <endgame/io.h>
+#include <endgame/scene.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ENDGAME_API
+#ifdef __GNUC__
+#define ENDGAME_API __attribute__((visibility("default")))
+#elif defined(_MSC_VER)
+#define ENDGAME_API __declspec(dllexport)
+#else
+#define ENDGAME_API // nothing
+#endif
+#endif
+
+/// an independently drawn rectangle of an I/O device
+///
+/// A panel has its own grid of cells, addressed relative to its top left
+/// corner, that text and scenes can be drawn into. Anything drawn beyond the
+/// panel’s edges is clipped. When the I/O device is synchronised, rows of each
+/// panel whose content has changed since they were last displayed are copied
+/// onto the device. So a fast-changing game view and a slow-changing sidebar
+/// can be drawn at different rates, without either repainting the other.
+///
+/// Panels are composited in the order they were created, with later panels
+/// covering earlier ones where they overlap. A panel assumes it has sole
+/// ownership of its area of the I/O device, other than for panels covering it.
+/// If anything else draws over this area (including `eg_io_clear`, which
+/// invalidates every panel itself), call `eg_panel_invalidate`.
+typedef struct eg_panel eg_panel_t;
+
+/// create a blank panel
+///
+/// The panel refers to, but does not take ownership of, `io`, which must
+/// outlive the panel. The panel is composited onto `io` from the next sync
+/// onwards.
+///
+/// \param me [out] Created panel on success
+/// \param io Device to composite onto
+/// \param x Column of the I/O device at which the panel’s left edge sits
+/// \param y Row of the I/O device at which the panel’s top edge sits
+/// \param columns Width of the panel
+/// \param rows Height of the panel
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_panel_new(eg_panel_t **me, eg_io_t *io, size_t x, size_t y,
+                             size_t columns, size_t rows);
+
+/// get the width of a panel
+ENDGAME_API size_t eg_panel_get_columns(const eg_panel_t *me);
+
+/// get the height of a panel
+ENDGAME_API size_t eg_panel_get_rows(const eg_panel_t *me);
+
+/// write text to a panel
+///
+/// \param me Panel to write to
+/// \param x Column of the panel at which to begin the write
+/// \param y Row of the panel at which to begin the write
+/// \param text Text to write
+/// \param len Number of bytes in `text`
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_panel_put(eg_panel_t *me, size_t x, size_t y,
+                             const char *text, size_t len);
+
+/// write a null terminated string to a panel
+///
+/// \param me Panel to write to
+/// \param x Column of the panel at which to begin the write
+/// \param y Row of the panel at which to begin the write
+/// \param text String to write
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_panel_puts(eg_panel_t *me, size_t x, size_t y,
+                              const char *text);
+
+/// write `printf`-style arguments to a panel
+///
+/// \param me Panel to write to
+/// \param x Column of the panel at which to begin the write
+/// \param y Row of the panel at which to begin the write
+/// \param format A `printf`-style format string
+/// \param ... `printf`-style format arguments
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_panel_print(eg_panel_t *me, size_t x, size_t y,
+                               const char *format, ...);
+
+/// draw a scene into a panel
+///
+/// This is equivalent to `eg_scene_paint`, but fills the panel rather than the
+/// whole I/O device.
+///
+/// \param me Panel to draw into
+/// \param scene Scene to draw
+/// \param origin Coordinates within the scene to display at the top left of
+///   the panel
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_panel_paint_scene(eg_panel_t *me, eg_scene_t *scene,
+                                     eg_2D_t origin);
+
+/// blank a panel
+///
+/// \param me Panel to clear
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_panel_clear(eg_panel_t *me);
+
+/// discard a panel’s record of what it last displayed
+///
+/// The next sync will copy the whole panel onto the I/O device.
+///
+/// \param me Panel to invalidate
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_panel_invalidate(eg_panel_t *me);
+
+/// destroy a panel
+///
+/// The panel stops being composited. What it last displayed is left on the
+/// I/O device.
+ENDGAME_API void eg_panel_free(eg_panel_t **me);
+
+#ifdef __cplusplus
+}
+#endif
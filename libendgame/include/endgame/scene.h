@@ -2,6 +2,7 @@
 
 #include <endgame/io.h>
 #include <endgame/sprite.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -24,11 +25,33 @@ extern "C" {
 /// Sprites themselves are positioned with 3-D coordinates. But the Z axis is
 /// used only to prioritise one sprite to be positioned “on top” of another when
 /// displayed in 2-D.
+///
+/// Sprites are grouped into layers. When displayed, layers are stacked on top
+/// of each other, with empty cells in one layer letting those below it show
+/// through.
 typedef struct eg_scene eg_scene_t;
 
 /// an opaque handle for a sprite installed in a scene
 typedef void *eg_sprite_handle_p;
 
+/// an opaque handle for a layer within a scene
+typedef void *eg_layer_handle_p;
+
+/// an opaque handle for a tilemap installed in a scene
+typedef void *eg_tilemap_handle_p;
+
+/// a tile within a tilemap
+///
+/// This is an index into the tilemap’s palette, offset by 1. That is, tile `n`
+/// is displayed as the palette’s form `n - 1`, and tile 0 is empty.
+typedef uint16_t eg_tile_t;
+
+/// type of a layer, as passed to `eg_scene_add_layer`
+typedef enum {
+  EG_LAYER_DYNAMIC, ///< a layer whose sprites change frequently
+  EG_LAYER_STATIC,  ///< a layer whose sprites rarely or never change
+} eg_layer_type_t;
+
 /// create a new scene
 ///
 /// This function must be called before using any of the other functions in this
@@ -38,8 +61,35 @@ typedef void *eg_sprite_handle_p;
 /// \return 0 on success or an errno on failure
 ENDGAME_API int eg_scene_new(eg_scene_t **me);
 
+/// add a layer to a scene
+///
+/// Every scene starts with a single dynamic layer at Z 0, into which
+/// `eg_scene_add` places sprites. This function creates further layers, e.g. a
+/// background below this or a heads-up display above it. Layers with a higher
+/// Z are displayed on top of those with a lower Z. Layers with equal Z are
+/// displayed in the order in which they were added, most recent on top.
+///
+/// Each layer is synchronised independently, so modifying the sprites in one
+/// does not incur any cost for the others. Static layers are additionally
+/// rasterised once during synchronisation into a cached grid of cells
+/// covering all their sprites, which is then composited directly each time the
+/// scene is painted. This makes painting large, unchanging backgrounds cheap at
+/// the cost of memory proportional to the area their sprites span, and of
+/// re-rasterising the layer whenever any of its sprites change.
+///
+/// \param me Scene to operate on
+/// \param z Position of the layer within the stack of layers
+/// \param type Whether the layer should be treated as static or dynamic
+/// \param handle [out] Handle to the added layer on success
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_add_layer(eg_scene_t *me, int64_t z,
+                                   eg_layer_type_t type,
+                                   eg_layer_handle_p *handle);
+
 /// add a sprite to a scene
 ///
+/// The sprite is placed in the scene’s default layer.
+///
 /// \param me Scene to operate on
 /// \param x Starting X position of the sprite
 /// \param y Starting Y position of the sprite
@@ -51,6 +101,77 @@ ENDGAME_API int eg_scene_add(eg_scene_t *me, int64_t x, int64_t y, int64_t z,
                              const eg_sprite_t *sprite,
                              eg_sprite_handle_p *handle);
 
+/// add a sprite to a specific layer of a scene
+///
+/// If you pass a layer handle derived from a different scene than the one
+/// passed, then behaviour is undefined.
+///
+/// \param me Scene to operate on
+/// \param layer Handle to the layer to place the sprite in
+/// \param x Starting X position of the sprite
+/// \param y Starting Y position of the sprite
+/// \param z Starting Z position of the sprite within its layer
+/// \param sprite Definition of sprite to place
+/// \param handle [out] Handle to the added sprite on success
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_add_to(eg_scene_t *me, eg_layer_handle_p layer,
+                                int64_t x, int64_t y, int64_t z,
+                                const eg_sprite_t *sprite,
+                                eg_sprite_handle_p *handle);
+
+/// add a tilemap to a layer of a scene
+///
+/// Tilemaps are a dense alternative to sprites, intended for content like
+/// terrain where most cells are occupied. Rather than each cell containing a
+/// separately positioned sprite, a tilemap stores a small tile index per cell
+/// referring to a palette of forms shared by the whole tilemap. Tiles are
+/// stored in fixed size chunks that are allocated on demand when tiles within
+/// them are first set, so tilemaps can extend as far in any direction as
+/// needed. Tilemaps are initially empty.
+///
+/// A layer’s tilemaps are displayed beneath its sprites, in the order they were
+/// added. If you pass a layer handle derived from a different scene than the
+/// one passed, then behaviour is undefined.
+///
+/// \param me Scene to operate on
+/// \param layer Handle to the layer to place the tilemap in
+/// \param palette Forms that tiles in the tilemap can take
+/// \param handle [out] Handle to the added tilemap on success
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_add_tilemap(eg_scene_t *me, eg_layer_handle_p layer,
+                                     const eg_sprite_t *palette,
+                                     eg_tilemap_handle_p *handle);
+
+/// set a tile within a tilemap
+///
+/// Unlike modifying sprites, setting tiles does not require a following
+/// `eg_scene_sync`. If you pass a tilemap handle derived from a different scene
+/// than the one passed, then behaviour is undefined.
+///
+/// \param me Scene to operate on
+/// \param tilemap Handle to tilemap to alter
+/// \param x X position of the tile
+/// \param y Y position of the tile
+/// \param tile Tile to set, 0 to clear
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_set_tile(eg_scene_t *me, eg_tilemap_handle_p tilemap,
+                                  int64_t x, int64_t y, eg_tile_t tile);
+
+/// get a tile within a tilemap
+///
+/// If you pass a tilemap handle derived from a different scene than the one
+/// passed, then behaviour is undefined.
+///
+/// \param me Scene to read from
+/// \param tilemap Handle to tilemap to read
+/// \param x X position of the tile
+/// \param y Y position of the tile
+/// \param tile [out] Tile at the given position, 0 if empty
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_get_tile(const eg_scene_t *me,
+                                  eg_tilemap_handle_p tilemap, int64_t x,
+                                  int64_t y, eg_tile_t *tile);
+
 /// synchronise internal bookkeeping
 ///
 /// After modifying the sprites in a scene, internal data structures must be
@@ -64,11 +185,16 @@ ENDGAME_API int eg_scene_add(eg_scene_t *me, int64_t x, int64_t y, int64_t z,
 ///
 /// What counts as modification:
 ///   • `eg_scene_add`
+///   • `eg_scene_add_to`
 ///   • `eg_scene_move`
+///   • `eg_scene_morph`
 ///   • `eg_scene_remove`
 ///
-/// If you do not call this before calling `eg_scene_paint`, it will be done for
-/// you.
+/// Only layers that have been modified since the last synchronisation incur
+/// any work.
+///
+/// If you do not call this before calling `eg_scene_paint` or querying the
+/// scene, it will be done for you.
 ///
 /// \param me Scene to synchronise
 ENDGAME_API void eg_scene_sync(eg_scene_t *me);
@@ -102,6 +228,64 @@ typedef struct {
 /// \return 0 on success or an errno on failure
 ENDGAME_API int eg_scene_paint(eg_scene_t *me, eg_io_t *io, eg_2D_t origin);
 
+/// find the sprites occupying a point within a scene
+///
+/// A sprite occupies every cell its current form covers, so a wide form is
+/// found at any of the points it spans. Only sprites are considered, not tiles.
+/// The scene is synchronised first if necessary, after which each layer is
+/// searched in time logarithmic in its number of sprites.
+///
+/// Sprites are listed from the bottom layer up, and within a layer ordered by
+/// {x,z}. A wide form to the left of the point therefore precedes any sprites
+/// positioned exactly at it.
+///
+/// \param me Scene to search
+/// \param point Position to look at
+/// \param handles [out] Storage for up to `capacity` handles of sprites found
+/// \param capacity Number of entries available in `handles`
+/// \param n [out] Number of sprites found, which may exceed `capacity` in
+///   which case only the first `capacity` are written to `handles`
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_query_point(eg_scene_t *me, eg_2D_t point,
+                                     eg_sprite_handle_p *handles,
+                                     size_t capacity, size_t *n);
+
+/// find the sprites intersecting a rectangle within a scene
+///
+/// This is like `eg_scene_query_point`, but finds any sprite occupying at
+/// least one cell within an area. Its cost depends on the number of rows in
+/// the area containing sprites, not the area’s overall size. Sprites are listed
+/// from the bottom layer up, and within a layer ordered by {y,x,z}.
+///
+/// \param me Scene to search
+/// \param top_left Top left corner of the area to search
+/// \param bottom_right Bottom right corner of the area to search, inclusive
+/// \param handles [out] Storage for up to `capacity` handles of sprites found
+/// \param capacity Number of entries available in `handles`
+/// \param n [out] Number of sprites found, which may exceed `capacity` in
+///   which case only the first `capacity` are written to `handles`
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_query_rect(eg_scene_t *me, eg_2D_t top_left,
+                                    eg_2D_t bottom_right,
+                                    eg_sprite_handle_p *handles,
+                                    size_t capacity, size_t *n);
+
+/// set the number of threads used to synchronise and paint a scene
+///
+/// Painting a large view box can be split across multiple threads, each
+/// rasterising a horizontal band of it. Only rasterisation happens in parallel;
+/// the result is always written to the I/O device from the calling thread.
+/// Similarly, synchronising a layer containing many sprites sorts them across
+/// multiple threads. Threads are started by this function and persist until the
+/// scene is freed or this function is called again. View boxes and layers too
+/// small to benefit from this are still handled solely on the calling thread.
+///
+/// \param me Scene to configure
+/// \param threads Total number of threads to use, including the calling
+///   thread. ≤1 disables parallelism, which is the default.
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_set_threads(eg_scene_t *me, size_t threads);
+
 /// move an existing sprite within a scene
 ///
 /// If you pass a sprite handle derived from a different scene than the one
@@ -137,6 +321,79 @@ ENDGAME_API int eg_scene_morph(eg_scene_t *me, eg_sprite_handle_p subject,
 /// \return 0 on success or an errno on failure
 ENDGAME_API int eg_scene_remove(eg_scene_t *me, eg_sprite_handle_p handle);
 
+/// the state of a sprite at one side of a change
+typedef struct {
+  int64_t x;
+  int64_t y;
+  int64_t z;
+  size_t form; ///< index of the sprite’s current form
+} eg_placement_t;
+
+/// type of a change recorded in a scene’s journal
+typedef enum {
+  EG_CHANGE_ADD,    ///< a sprite was added
+  EG_CHANGE_MOVE,   ///< a sprite was moved
+  EG_CHANGE_MORPH,  ///< a sprite changed form
+  EG_CHANGE_REMOVE, ///< a sprite was removed
+} eg_change_type_t;
+
+/// a modification to a sprite within a scene
+typedef struct {
+  eg_change_type_t type;
+
+  /// the sprite that was modified
+  ///
+  /// After an `EG_CHANGE_REMOVE`, this handle is no longer valid and its value
+  /// may be reused by a sprite added later in the journal. It is only useful
+  /// for identifying which sprite was removed.
+  eg_sprite_handle_p sprite;
+
+  eg_layer_handle_p layer; ///< layer the sprite belongs to
+
+  /// state of the sprite prior to the change, zeroed for `EG_CHANGE_ADD`
+  eg_placement_t before;
+
+  /// state of the sprite following the change, zeroed for `EG_CHANGE_REMOVE`
+  eg_placement_t after;
+} eg_change_t;
+
+/// enable or disable recording of a scene’s sprite changes
+///
+/// While enabled, every `eg_scene_add`, `eg_scene_add_to`, `eg_scene_move`,
+/// `eg_scene_morph`, and `eg_scene_remove` appends a record to the scene’s
+/// journal. Systems that track the scene (rendering, collision, replication,
+/// …) can then process what changed since they last looked, rather than
+/// comparing whole snapshots of the scene. Tile changes are not recorded.
+///
+/// The journal grows until cleared with `eg_scene_clear_changes`, so a scene
+/// whose journal is enabled should have it cleared regularly, e.g. once per
+/// tick. Disabling the journal discards any recorded changes. Journalling is
+/// disabled by default.
+///
+/// \param me Scene to configure
+/// \param enable Whether to record changes
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_set_journal(eg_scene_t *me, bool enable);
+
+/// retrieve the changes recorded in a scene’s journal
+///
+/// Changes are listed in the order they were made. Reading them does not
+/// remove them, so multiple consumers can each process the same changes before
+/// they are cleared. The returned array remains valid until the scene is next
+/// modified, cleared, or freed.
+///
+/// \param me Scene to read from
+/// \param changes [out] Recorded changes, oldest first
+/// \param n [out] Number of entries in `changes`
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_scene_get_changes(const eg_scene_t *me,
+                                     const eg_change_t **changes, size_t *n);
+
+/// discard the changes recorded in a scene’s journal
+///
+/// \param me Scene whose journal to empty
+ENDGAME_API void eg_scene_clear_changes(eg_scene_t *me);
+
 /// reverse the setup steps from `eg_scene_new`
 ///
 /// After calling this function, `eg_scene_new` must be called again before
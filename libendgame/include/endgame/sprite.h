@@ -13,6 +13,10 @@ typedef struct {
   /// e.g. `{"<", ">", NULL}` for an arrow that can be pointing either left or
   /// right. The list of forms is expected to be terminated with a null entry,
   /// as in the preceding examples.
+  ///
+  /// Forms may be wider than a single cell. E.g. most emoji occupy two terminal
+  /// columns. When painted, such a form covers the cells to its right, hiding
+  /// any sprites positioned there.
   const char **forms;
 } eg_sprite_t;
 
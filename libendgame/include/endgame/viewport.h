@@ -0,0 +1,82 @@
+#pragma once
+
+#include <endgame/io.h>
+#include <endgame/scene.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ENDGAME_API
+#ifdef __GNUC__
+#define ENDGAME_API __attribute__((visibility("default")))
+#elif defined(_MSC_VER)
+#define ENDGAME_API __declspec(dllexport)
+#else
+#define ENDGAME_API // nothing
+#endif
+#endif
+
+/// a persistent view of a scene, displayed on part of an I/O device
+///
+/// Unlike `eg_scene_paint`, a viewport remembers what it last displayed. When
+/// painted again, it only rasterises rows of the scene that have been modified
+/// since, and only writes cells whose content changed. If nothing relevant has
+/// changed, painting does no work at all.
+///
+/// A viewport assumes it has sole ownership of its area of the I/O device. If
+/// anything else draws over this area (including `eg_io_clear`), call
+/// `eg_viewport_invalidate` so the next paint redraws it in full.
+///
+/// Multiple viewports can display the same scene, e.g. a main view and a
+/// minimap, each with their own origin and cache.
+typedef struct eg_viewport eg_viewport_t;
+
+/// create a viewport
+///
+/// The viewport refers to, but does not take ownership of, `scene` and `io`.
+/// Both must outlive the viewport.
+///
+/// \param me [out] Created viewport on success
+/// \param scene Scene to display
+/// \param io Device to draw onto
+/// \param x Column of the I/O device at which the viewport’s left edge sits
+/// \param y Row of the I/O device at which the viewport’s top edge sits
+/// \param columns Width of the viewport
+/// \param rows Height of the viewport
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_viewport_new(eg_viewport_t **me, eg_scene_t *scene,
+                                eg_io_t *io, size_t x, size_t y,
+                                size_t columns, size_t rows);
+
+/// change which part of the scene a viewport displays
+///
+/// \param me Viewport to update
+/// \param origin Coordinates within the scene to display at the top left of
+///   the viewport
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_viewport_set_origin(eg_viewport_t *me, eg_2D_t origin);
+
+/// draw any changes to the viewport’s view of its scene
+///
+/// The scene is synchronised first, if necessary.
+///
+/// \param me Viewport to paint
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_viewport_paint(eg_viewport_t *me);
+
+/// discard a viewport’s record of what it last displayed
+///
+/// The next call to `eg_viewport_paint` will redraw the viewport in full.
+///
+/// \param me Viewport to invalidate
+/// \return 0 on success or an errno on failure
+ENDGAME_API int eg_viewport_invalidate(eg_viewport_t *me);
+
+/// destroy a viewport
+ENDGAME_API void eg_viewport_free(eg_viewport_t **me);
+
+#ifdef __cplusplus
+}
+#endif
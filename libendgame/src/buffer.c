@@ -0,0 +1,117 @@
+#include "buffer.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// ensure a buffer has space for a given number of extra bytes
+static int reserve(buffer_t *me, size_t len) {
+  assert(me != NULL);
+
+  if (me->cap - me->len >= len)
+    return 0;
+
+  size_t c = me->cap == 0 ? 4096 : me->cap;
+  while (c - me->len < len)
+    c *= 2;
+
+  char *const d = realloc(me->data, c);
+  if (d == NULL)
+    return ENOMEM;
+  me->data = d;
+  me->cap = c;
+
+  return 0;
+}
+
+int buffer_append(buffer_t *me, const char *data, size_t len) {
+  assert(me != NULL);
+  assert(data != NULL || len == 0);
+
+  const int rc = reserve(me, len);
+  if (rc != 0)
+    return rc;
+
+  if (len > 0)
+    memcpy(&me->data[me->len], data, len);
+  me->len += len;
+
+  return 0;
+}
+
+int buffer_append_num(buffer_t *me, size_t n) {
+  assert(me != NULL);
+
+  // render digits backwards into a temporary
+  char digits[sizeof(n) * 3];
+  size_t i = sizeof(digits);
+  do {
+    digits[--i] = (char)('0' + n % 10);
+    n /= 10;
+  } while (n > 0);
+
+  return buffer_append(me, &digits[i], sizeof(digits) - i);
+}
+
+int buffer_append_fill(buffer_t *me, char c, size_t n) {
+  assert(me != NULL);
+
+  const int rc = reserve(me, n);
+  if (rc != 0)
+    return rc;
+
+  if (n > 0)
+    memset(&me->data[me->len], c, n);
+  me->len += n;
+
+  return 0;
+}
+
+int buffer_vprintf(buffer_t *me, const char *format, va_list ap) {
+  assert(me != NULL);
+  assert(format != NULL);
+
+  va_list ap2;
+  va_copy(ap2, ap);
+  int rc = 0;
+
+  // format into the remaining space, learning how long the result is
+  const size_t avail = me->cap - me->len;
+  const int len = vsnprintf(avail == 0 ? NULL : &me->data[me->len], avail,
+                            format, ap);
+  if (len < 0) {
+    rc = errno == 0 ? EINVAL : errno;
+    goto done;
+  }
+
+  // if it did not fit, grow the buffer and try again
+  if ((size_t)len >= avail) {
+    if ((rc = reserve(me, (size_t)len + 1)))
+      goto done;
+    if (vsnprintf(&me->data[me->len], me->cap - me->len, format, ap2) < 0) {
+      rc = errno == 0 ? EINVAL : errno;
+      goto done;
+    }
+  }
+
+  me->len += (size_t)len;
+
+done:
+  va_end(ap2);
+
+  return rc;
+}
+
+void buffer_reset(buffer_t *me) {
+  assert(me != NULL);
+  me->len = 0;
+}
+
+void buffer_free(buffer_t *me) {
+  assert(me != NULL);
+  free(me->data);
+  *me = (buffer_t){0};
+}
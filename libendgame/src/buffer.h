@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/// a growable array of bytes
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+} buffer_t;
+
+/// append bytes to a buffer
+///
+/// \param me Buffer to append to
+/// \param data Bytes to append
+/// \param len Number of bytes in `data`
+/// \return 0 on success or an errno on failure
+int buffer_append(buffer_t *me, const char *data, size_t len);
+
+/// append the decimal representation of a number to a buffer
+///
+/// \param me Buffer to append to
+/// \param n Number to append
+/// \return 0 on success or an errno on failure
+int buffer_append_num(buffer_t *me, size_t n);
+
+/// append repetitions of a byte to a buffer
+///
+/// \param me Buffer to append to
+/// \param c Byte to append
+/// \param n Number of times to append `c`
+/// \return 0 on success or an errno on failure
+int buffer_append_fill(buffer_t *me, char c, size_t n);
+
+/// append formatted text to a buffer
+///
+/// The buffer is grown as necessary to fit the text. A terminating null byte is
+/// written after it, but not counted in `len`.
+///
+/// \param me Buffer to append to
+/// \param format A printf-style format string
+/// \param ap Arguments to `format`
+/// \return 0 on success or an errno on failure
+int buffer_vprintf(buffer_t *me, const char *format, va_list ap);
+
+/// discard the contents of a buffer, retaining its allocated space
+void buffer_reset(buffer_t *me);
+
+/// deallocate the backing memory of a buffer
+void buffer_free(buffer_t *me);
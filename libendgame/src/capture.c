@@ -0,0 +1,106 @@
+#include "capture.h"
+#include "clock.h"
+#include <assert.h>
+#include <endgame/output.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/// marker separating frames in a raw capture
+///
+/// This is an Application Program Command, which terminals ignore, so a raw
+/// capture can still be replayed by writing it to a terminal.
+static const char FRAME[] = "\033_endgame:frame\033\\";
+
+int capture_start(capture_t *me, FILE *file, eg_capture_format_t format,
+                  size_t columns, size_t rows) {
+  assert(me != NULL);
+  assert(file != NULL);
+
+  *me = (capture_t){.file = file, .format = format, .start = now_ns()};
+
+  if (format == EG_CAPTURE_ASCIICAST) {
+    if (fprintf(file,
+                "{\"version\": 2, \"width\": %zu, \"height\": %zu, "
+                "\"timestamp\": %lld}\n",
+                columns, rows, (long long)time(NULL)) < 0)
+      return EIO;
+  }
+
+  return 0;
+}
+
+/// start an asciicast event
+static int event(capture_t *me, char type) {
+  assert(me != NULL);
+
+  const uint64_t t = now_ns() - me->start;
+  if (fprintf(me->file, "[%llu.%06llu, \"%c\", \"",
+              (unsigned long long)(t / 1000000000),
+              (unsigned long long)(t % 1000000000 / 1000), type) < 0)
+    return EIO;
+
+  return 0;
+}
+
+int capture_write(capture_t *me, const char *data, size_t len) {
+  assert(me != NULL);
+  assert(data != NULL || len == 0);
+
+  if (me->file == NULL || len == 0)
+    return 0;
+
+  if (me->format == EG_CAPTURE_RAW) {
+    if (fwrite(data, 1, len, me->file) < len)
+      return EIO;
+    return 0;
+  }
+
+  int rc = 0;
+  if ((rc = event(me, 'o')))
+    return rc;
+
+  // write the data as a JSON string
+  for (size_t i = 0; i < len; ++i) {
+    const unsigned char c = (unsigned char)data[i];
+    int r;
+    if (c == '"' || c == '\\') {
+      r = fprintf(me->file, "\\%c", c);
+    } else if (c < 0x20 || c == 0x7f) {
+      r = fprintf(me->file, "\\u%04x", c);
+    } else {
+      r = putc(c, me->file);
+    }
+    if (r < 0)
+      return EIO;
+  }
+
+  if (fputs("\"]\n", me->file) < 0)
+    return EIO;
+
+  return 0;
+}
+
+int capture_frame(capture_t *me) {
+  assert(me != NULL);
+
+  if (me->file == NULL)
+    return 0;
+
+  if (me->format == EG_CAPTURE_RAW) {
+    if (fwrite(FRAME, 1, sizeof(FRAME) - 1, me->file) < sizeof(FRAME) - 1)
+      return EIO;
+    return 0;
+  }
+
+  int rc = 0;
+  if ((rc = event(me, 'm')))
+    return rc;
+
+  if (fputs("\"]\n", me->file) < 0)
+    return EIO;
+
+  return 0;
+}
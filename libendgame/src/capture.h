@@ -0,0 +1,38 @@
+#pragma once
+
+#include <endgame/output.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// a copy of terminal output being saved to a file
+typedef struct {
+  FILE *file; ///< stream to save to, `NULL` if not capturing
+  eg_capture_format_t format;
+  uint64_t start; ///< time (ns) capturing began
+} capture_t;
+
+/// begin capturing
+///
+/// \param me Capture to initialise
+/// \param file Stream to save to
+/// \param format How to save output
+/// \param columns Width of the terminal
+/// \param rows Height of the terminal
+/// \return 0 on success or an errno on failure
+int capture_start(capture_t *me, FILE *file, eg_capture_format_t format,
+                  size_t columns, size_t rows);
+
+/// save some terminal output
+///
+/// \param me Capture to write to
+/// \param data Bytes that were written to the terminal
+/// \param len Number of bytes in `data`
+/// \return 0 on success or an errno on failure
+int capture_write(capture_t *me, const char *data, size_t len);
+
+/// mark the end of a frame
+///
+/// \param me Capture to write to
+/// \return 0 on success or an errno on failure
+int capture_frame(capture_t *me);
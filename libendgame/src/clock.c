@@ -0,0 +1,18 @@
+#include "clock.h"
+#include <stdint.h>
+#include <time.h>
+
+// CLOCK_MONOTONIC is required by POSIX, so reading it can only fail with
+// invalid arguments, which these never pass
+
+uint64_t now_ms(void) {
+  struct timespec ts = {0};
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+uint64_t now_ns(void) {
+  struct timespec ts = {0};
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+/// read a monotonic clock in milliseconds
+uint64_t now_ms(void);
+
+/// read a monotonic clock in nanoseconds
+uint64_t now_ns(void);
@@ -0,0 +1,114 @@
+#include "form.h"
+#include "frame.h"
+#include "split.h"
+#include "width.h"
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// split a form’s text into the cells it occupies
+static int encode(form_t *f) {
+  assert(f != NULL);
+  assert(f->text != NULL);
+
+  const size_t len = strlen(f->text);
+  split_t split;
+  const char *cluster;
+  size_t n;
+  size_t width;
+
+  // measure how much space we need
+  size_t n_cells = 0;
+  size_t bytes = 0;
+  split_init(&split, f->text, len);
+  while (split_next(&split, &cluster, &n, &width)) {
+    ++n_cells;
+    if (!split_is_blank(&split, cluster, n))
+      bytes += split_encoded_len(&split, n);
+  }
+
+  f->cells = calloc(n_cells, sizeof(f->cells[0]));
+  if (n_cells > 0 && f->cells == NULL)
+    return ENOMEM;
+  f->encoded = malloc(bytes);
+  if (bytes > 0 && f->encoded == NULL)
+    return ENOMEM;
+
+  size_t i = 0;
+  size_t offset = 0;
+  split_init(&split, f->text, len);
+  while (split_next(&split, &cluster, &n, &width)) {
+    encoded_t *const c = &f->cells[i++];
+    c->width = (uint8_t)width;
+    if (split_is_blank(&split, cluster, n))
+      continue;
+    const size_t total = split_encoded_len(&split, n);
+    if (total > UINT16_MAX)
+      return ERANGE;
+    split_encode(&split, cluster, n, &f->encoded[offset]);
+    c->bytes = &f->encoded[offset];
+    c->len = (uint16_t)total;
+    offset += total;
+  }
+  f->n_cells = n_cells;
+
+  return 0;
+}
+
+int forms_new(form_t **forms, size_t *n_forms, const char **defn) {
+  assert(forms != NULL);
+  assert(n_forms != NULL);
+  assert(defn != NULL);
+
+  *forms = NULL;
+  *n_forms = 0;
+  form_t *fs = NULL;
+  size_t n = 0;
+  int rc = 0;
+
+  while (defn[n] != NULL)
+    ++n;
+
+  fs = calloc(n, sizeof(fs[0]));
+  if (n > 0 && fs == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    fs[i].text = strdup(defn[i]);
+    if (fs[i].text == NULL) {
+      rc = ENOMEM;
+      goto done;
+    }
+    fs[i].width = display_width(defn[i], strlen(defn[i]));
+    if ((rc = encode(&fs[i])))
+      goto done;
+  }
+
+  *forms = fs;
+  *n_forms = n;
+  fs = NULL;
+
+done:
+  if (fs != NULL)
+    forms_free(fs, n);
+
+  return rc;
+}
+
+void forms_free(form_t *forms, size_t n_forms) {
+
+  if (forms == NULL)
+    return;
+
+  for (size_t i = 0; i < n_forms; ++i) {
+    free(forms[i].text);
+    free(forms[i].cells);
+    free(forms[i].encoded);
+  }
+  free(forms);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "frame.h"
+#include <stddef.h>
+
+/// a visual form of a sprite or tile
+typedef struct {
+  char *text; ///< UTF-8 text to display
+
+  /// number of terminal columns `text` occupies
+  ///
+  /// This is measured once when the form is created, to avoid decoding UTF-8
+  /// every time the form is painted.
+  size_t width;
+
+  /// `text` split into the cells it occupies
+  ///
+  /// This is prepared once when the form is created, so painting the form
+  /// involves no scanning of its text.
+  encoded_t *cells;
+  size_t n_cells;
+  char *encoded; ///< backing storage for the bytes of `cells`
+} form_t;
+
+/// create forms from their definition
+///
+/// \param forms [out] Created forms on success
+/// \param n_forms [out] Number of entries in `forms` on success
+/// \param defn Null-terminated list of form texts
+/// \return 0 on success or an errno on failure
+int forms_new(form_t **forms, size_t *n_forms, const char **defn);
+
+/// free forms created by `forms_new`
+///
+/// \param forms Forms to free
+/// \param n_forms Number of entries in `forms`
+void forms_free(form_t *forms, size_t n_forms);
@@ -0,0 +1,766 @@
+#include "frame.h"
+#include "buffer.h"
+#include "glyph.h"
+#include "scan.h"
+#include "split.h"
+#include "width.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int frame_new(frame_t *me, glyphs_t *glyphs, size_t rows, size_t columns) {
+  assert(me != NULL);
+  assert(glyphs != NULL);
+
+  *me = (frame_t){.rows = rows, .columns = columns, .glyphs = glyphs};
+
+  me->cells = malloc(rows * columns * sizeof(me->cells[0]));
+  if (rows * columns > 0 && me->cells == NULL)
+    return ENOMEM;
+
+  me->hashes = malloc(rows * sizeof(me->hashes[0]));
+  if (rows > 0 && me->hashes == NULL) {
+    frame_free(me);
+    return ENOMEM;
+  }
+
+  frame_clear(me);
+
+  return 0;
+}
+
+/// columns occupied by a glyph
+static size_t width_of(const frame_t *me, glyph_t glyph) {
+  assert(me != NULL);
+  if (glyph == GLYPH_BLANK)
+    return 1;
+  if (glyph == GLYPH_COVERED)
+    return 0;
+  return glyphs_get(me->glyphs, glyph)->width;
+}
+
+/// contribution of a cell to the hash of its row
+///
+/// Blank cells contribute nothing, so a blank row hashes to 0.
+static uint64_t mix(size_t x, glyph_t glyph) {
+  if (glyph == GLYPH_BLANK)
+    return 0;
+
+  // splitmix64 finaliser
+  uint64_t z = ((uint64_t)x << 32) | glyph;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/// write a single cell, keeping its row’s hash up to date
+static void set(frame_t *me, size_t x, size_t y, glyph_t glyph) {
+  assert(me != NULL);
+  assert(x < me->columns);
+  assert(y < me->rows);
+
+  glyph_t *const cell = &me->cells[y * me->columns + x];
+  me->hashes[y] ^= mix(x, *cell) ^ mix(x, glyph);
+  *cell = glyph;
+}
+
+/// recompute the hash of every row
+static void rehash(frame_t *me) {
+  assert(me != NULL);
+
+  for (size_t y = 0; y < me->rows; ++y) {
+    uint64_t h = 0;
+    for (size_t x = 0; x < me->columns; ++x)
+      h ^= mix(x, me->cells[y * me->columns + x]);
+    me->hashes[y] = h;
+  }
+}
+
+/// blank whatever occupies a given cell
+static void erase(frame_t *me, size_t x, size_t y) {
+  assert(me != NULL);
+  assert(x < me->columns);
+  assert(y < me->rows);
+
+  const glyph_t *const row = &me->cells[y * me->columns];
+
+  // find the start of the cell covering this one
+  size_t start = x;
+  while (start > 0 && row[start] == GLYPH_COVERED)
+    --start;
+
+  const size_t width = width_of(me, row[start]);
+  for (size_t i = start; i < start + width && i < me->columns; ++i)
+    set(me, i, y, GLYPH_BLANK);
+}
+
+/// place a cell into a frame
+static void place(frame_t *me, size_t x, size_t y, glyph_t glyph,
+                  size_t width) {
+  assert(me != NULL);
+  assert(x + width <= me->columns);
+  assert(y < me->rows);
+  assert(width > 0);
+
+  // if we are overwriting either end of a wide cell, it is no longer visible
+  erase(me, x, y);
+  erase(me, x + width - 1, y);
+
+  set(me, x, y, glyph);
+  for (size_t i = 1; i < width; ++i)
+    set(me, x + i, y, GLYPH_COVERED);
+}
+
+/// intern the cluster just found by a split
+///
+/// \param me Frame whose glyph table to intern into
+/// \param split Splitting state the cluster came from
+/// \param cluster Cluster returned from `split_next`
+/// \param len Number of bytes in `cluster`
+/// \param width Columns the cluster occupies
+/// \param glyph [out] Resulting glyph
+/// \return 0 on success or an errno on failure
+static int intern(frame_t *me, const split_t *split, const char *cluster,
+                  size_t len, size_t width, glyph_t *glyph) {
+  assert(me != NULL);
+  assert(split != NULL);
+  assert(cluster != NULL);
+  assert(glyph != NULL);
+
+  if (split_is_blank(split, cluster, len)) {
+    *glyph = GLYPH_BLANK;
+    return 0;
+  }
+
+  if (split->attr_len == 0)
+    return glyphs_intern(me->glyphs, cluster, len, width, glyph);
+
+  // assemble the cell’s bytes, on the heap if they are unusually long
+  const size_t total = split_encoded_len(split, len);
+  char local[256];
+  char *const bytes = total <= sizeof(local) ? local : malloc(total);
+  if (bytes == NULL)
+    return ENOMEM;
+  split_encode(split, cluster, len, bytes);
+
+  const int rc = glyphs_intern(me->glyphs, bytes, total, width, glyph);
+
+  if (bytes != local)
+    free(bytes);
+
+  return rc;
+}
+
+int frame_put(frame_t *me, size_t x, size_t y, const char *text, size_t len) {
+  assert(me != NULL);
+  assert(text != NULL || len == 0);
+  assert(y < me->rows);
+
+  split_t split;
+  split_init(&split, text, len);
+
+  const char *cluster;
+  size_t n;
+  size_t width;
+  while (x < me->columns && split_next(&split, &cluster, &n, &width)) {
+
+    // a cluster that does not fit cannot be partially displayed
+    if (width > me->columns - x)
+      break;
+
+    glyph_t glyph;
+    const int rc = intern(me, &split, cluster, n, width, &glyph);
+    if (rc != 0)
+      return rc;
+
+    place(me, x, y, glyph, width);
+
+    x += width;
+  }
+
+  return 0;
+}
+
+int frame_put_encoded(frame_t *me, size_t x, size_t y, encoded_t *cells,
+                      size_t n) {
+  assert(me != NULL);
+  assert(cells != NULL || n == 0);
+  assert(y < me->rows);
+
+  for (size_t i = 0; i < n && x < me->columns; ++i) {
+    encoded_t *const c = &cells[i];
+
+    // a cell that does not fit cannot be partially displayed
+    if (c->width > me->columns - x)
+      break;
+
+    // reuse the glyph from last time, if it came from this table
+    if (c->bytes != NULL && c->serial != me->glyphs->serial) {
+      const int rc =
+          glyphs_intern(me->glyphs, c->bytes, c->len, c->width, &c->glyph);
+      if (rc != 0)
+        return rc;
+      c->serial = me->glyphs->serial;
+    }
+
+    place(me, x, y, c->bytes == NULL ? GLYPH_BLANK : c->glyph, c->width);
+
+    x += c->width;
+  }
+
+  return 0;
+}
+
+void frame_clear(frame_t *me) {
+  assert(me != NULL);
+
+  for (size_t i = 0; i < me->rows * me->columns; ++i)
+    me->cells[i] = GLYPH_BLANK;
+  for (size_t i = 0; i < me->rows; ++i)
+    me->hashes[i] = 0;
+}
+
+void frame_copy(frame_t *dst, const frame_t *src) {
+  assert(dst != NULL);
+  assert(src != NULL);
+  assert(dst != src);
+  assert(dst->rows == src->rows);
+  assert(dst->columns == src->columns);
+  assert(dst->glyphs == src->glyphs);
+
+  if (src->rows * src->columns > 0)
+    memcpy(dst->cells, src->cells,
+           src->rows * src->columns * sizeof(src->cells[0]));
+  if (src->rows > 0)
+    memcpy(dst->hashes, src->hashes, src->rows * sizeof(src->hashes[0]));
+}
+
+void frame_blit(frame_t *dst, size_t x, size_t y, const frame_t *src,
+                size_t src_y) {
+  assert(dst != NULL);
+  assert(y < dst->rows);
+  assert(src != NULL);
+  assert(src_y < src->rows);
+  assert(dst->glyphs == src->glyphs);
+
+  if (x >= dst->columns)
+    return;
+  const size_t n =
+      src->columns < dst->columns - x ? src->columns : dst->columns - x;
+  if (n == 0)
+    return;
+
+  // if we are overwriting either end of a wide cell, it is no longer visible
+  erase(dst, x, y);
+  erase(dst, x + n - 1, y);
+
+  const glyph_t *const row = &src->cells[src_y * src->columns];
+  for (size_t i = 0; i < n; ++i) {
+
+    // a cell that does not fit cannot be partially displayed
+    if (row[i] != GLYPH_COVERED && width_of(src, row[i]) > n - i) {
+      for (; i < n; ++i)
+        set(dst, x + i, y, GLYPH_BLANK);
+      break;
+    }
+
+    set(dst, x + i, y, row[i]);
+  }
+}
+
+int frame_compact(frame_t *const *frames, size_t n) {
+  assert(frames != NULL);
+  assert(n > 0);
+
+  glyphs_t *const old = frames[0]->glyphs;
+  glyphs_t fresh = {0};
+  glyph_t *map = NULL;
+  int rc = 0;
+
+  if ((rc = glyphs_new(&fresh)))
+    goto done;
+
+  // new identity of each old glyph, GLYPH_BLANK for those not yet seen
+  map = calloc(old->n, sizeof(map[0]));
+  if (map == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+  map[GLYPH_COVERED] = GLYPH_COVERED;
+
+  // re-intern each glyph in use, without yet altering the frames
+  for (size_t i = 0; i < n; ++i) {
+    const frame_t *const f = frames[i];
+    assert(f->glyphs == old);
+    for (size_t j = 0; j < f->rows * f->columns; ++j) {
+      const glyph_t c = f->cells[j];
+      if (c == GLYPH_BLANK || map[c] != GLYPH_BLANK)
+        continue;
+      const glyph_info_t *const g = glyphs_get(old, c);
+      if ((rc = glyphs_intern(&fresh, g->text, g->len, g->width, &map[c])))
+        goto done;
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    frame_t *const f = frames[i];
+    for (size_t j = 0; j < f->rows * f->columns; ++j)
+      f->cells[j] = map[f->cells[j]];
+    rehash(f);
+  }
+
+  glyphs_free(old);
+  *old = fresh;
+  fresh = (glyphs_t){0};
+
+done:
+  free(map);
+  glyphs_free(&fresh);
+
+  return rc;
+}
+
+/// number of bytes needed to display a cell
+static size_t cost(const frame_t *frame, glyph_t cell) {
+  return glyphs_get(frame->glyphs, cell)->len;
+}
+
+/// append the bytes that display a cell
+static int draw(buffer_t *out, const frame_t *frame, glyph_t cell) {
+  const glyph_info_t *const g = glyphs_get(frame->glyphs, cell);
+  return buffer_append(out, g->text, g->len);
+}
+
+/// number of decimal digits in a number
+static size_t digits(size_t n) {
+  size_t d = 1;
+  for (; n >= 10; n /= 10)
+    ++d;
+  return d;
+}
+
+/// append a control sequence with a single numeric parameter
+static int csi(buffer_t *out, size_t n, char final) {
+  int rc = 0;
+  if ((rc = buffer_append(out, "\033[", 2)))
+    return rc;
+  if ((rc = buffer_append_num(out, n)))
+    return rc;
+  return buffer_append(out, &final, 1);
+}
+
+/// bytes in a control sequence with a single numeric parameter
+static size_t csi_cost(size_t n) { return 3 + digits(n); }
+
+/// bytes in a cursor movement to the given 0-based position
+static size_t move_cost(size_t x, size_t y) {
+  return 3 + digits(y + 1) + (x > 0 ? 1 + digits(x + 1) : 0);
+}
+
+/// append a cursor movement to the given 0-based position
+static int move(buffer_t *out, size_t x, size_t y) {
+  int rc = 0;
+  if ((rc = buffer_append(out, "\033[", 2)))
+    return rc;
+  if ((rc = buffer_append_num(out, y + 1)))
+    return rc;
+  if (x > 0) {
+    if ((rc = buffer_append(out, ";", 1)))
+      return rc;
+    if ((rc = buffer_append_num(out, x + 1)))
+      return rc;
+  }
+  return buffer_append(out, "H", 1);
+}
+
+/// a row of a frame, keyed by its hash
+typedef struct {
+  uint64_t hash;
+  size_t row;
+} row_key_t;
+
+static int cmp_key(const void *a, const void *b) {
+  const row_key_t *const x = a;
+  const row_key_t *const y = b;
+  if (x->hash < y->hash)
+    return -1;
+  if (x->hash > y->hash)
+    return 1;
+  if (x->row < y->row)
+    return -1;
+  if (x->row > y->row)
+    return 1;
+  return 0;
+}
+
+/// find the only row with a given hash
+///
+/// \param keys Rows, sorted by hash
+/// \param n Number of entries in `keys`
+/// \param hash Hash to look for
+/// \param row [out] Row with the hash, if there is exactly one
+/// \return True if exactly one row has the hash
+static bool find_unique(const row_key_t *keys, size_t n, uint64_t hash,
+                        size_t *row) {
+  assert(keys != NULL || n == 0);
+  assert(row != NULL);
+
+  size_t lo = 0;
+  size_t hi = n;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (keys[mid].hash < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (lo == n || keys[lo].hash != hash)
+    return false;
+  if (lo + 1 < n && keys[lo + 1].hash == hash)
+    return false;
+
+  *row = keys[lo].row;
+  return true;
+}
+
+/// a region of the terminal to scroll
+typedef struct {
+  size_t top;      ///< first row of the region, 0-based
+  size_t bottom;   ///< last row of the region, inclusive
+  ptrdiff_t shift; ///< rows to move content up by, negative to move it down
+} scroll_t;
+
+/// number of bytes writing the non-blank cells of a row would take
+static size_t row_cost(const frame_t *me, size_t y) {
+  assert(me != NULL);
+  assert(y < me->rows);
+
+  size_t c = 0;
+  for (size_t x = 0; x < me->columns; ++x) {
+    const glyph_t g = me->cells[y * me->columns + x];
+    if (g != GLYPH_BLANK)
+      c += glyphs_get(me->glyphs, g)->len;
+  }
+  return c;
+}
+
+/// find a scroll of part of the terminal that would reuse rows already on it
+///
+/// \param front Frame currently displayed on the terminal
+/// \param back Frame to display
+/// \param keys Scratch space for `front->rows` entries
+/// \param votes Scratch space for `2 * front->rows` entries
+/// \param scroll [out] Worthwhile scroll, if one was found
+/// \return True if a worthwhile scroll was found
+static bool find_scroll(const frame_t *front, const frame_t *back,
+                        row_key_t *keys, size_t *votes, scroll_t *scroll) {
+  assert(front != NULL);
+  assert(back != NULL);
+  assert(keys != NULL);
+  assert(votes != NULL);
+  assert(scroll != NULL);
+
+  const size_t rows = back->rows;
+
+  // index the non-blank rows on the terminal by their content
+  size_t n = 0;
+  for (size_t y = 0; y < rows; ++y) {
+    if (front->hashes[y] != 0)
+      keys[n++] = (row_key_t){.hash = front->hashes[y], .row = y};
+  }
+  qsort(keys, n, sizeof(keys[0]), cmp_key);
+
+  // each changed row found elsewhere on the terminal votes for the distance it
+  // has moved
+  for (size_t i = 0; i < 2 * rows; ++i)
+    votes[i] = 0;
+  size_t best = 0;
+  for (size_t y = 0; y < rows; ++y) {
+    if (back->hashes[y] == 0 || back->hashes[y] == front->hashes[y])
+      continue;
+    size_t from;
+    if (!find_unique(keys, n, back->hashes[y], &from))
+      continue;
+    const size_t v = from + rows - y;
+    ++votes[v];
+    if (votes[v] > votes[best])
+      best = v;
+  }
+  if (votes[best] == 0)
+    return false;
+  const ptrdiff_t shift = (ptrdiff_t)best - (ptrdiff_t)rows;
+
+  // find the longest run of rows all moved by this distance, that includes a
+  // changed row
+  const size_t begin = shift < 0 ? (size_t)-shift : 0;
+  const size_t end = shift > 0 ? rows - (size_t)shift : rows;
+  size_t run_start = 0;
+  size_t run_len = 0;
+  size_t run_saving = 0;
+  for (size_t y = begin; y < end;) {
+    size_t len = 0;
+    size_t saving = 0;
+    while (y + len < end &&
+           back->hashes[y + len] ==
+               front->hashes[(size_t)((ptrdiff_t)(y + len) + shift)]) {
+      if (back->hashes[y + len] != front->hashes[y + len])
+        saving += row_cost(back, y + len);
+      ++len;
+    }
+    if (saving > run_saving) {
+      run_start = y;
+      run_len = len;
+      run_saving = saving;
+    }
+    y += len + 1;
+  }
+
+  // is scrolling cheaper than redrawing?
+  const size_t distance = (size_t)(shift < 0 ? -shift : shift);
+  if (run_saving <= 24 + 2 * distance)
+    return false;
+
+  if (shift > 0) {
+    *scroll = (scroll_t){.top = run_start,
+                         .bottom = run_start + run_len - 1 + distance,
+                         .shift = shift};
+  } else {
+    *scroll = (scroll_t){.top = run_start - distance,
+                         .bottom = run_start + run_len - 1,
+                         .shift = shift};
+  }
+  return true;
+}
+
+/// move the rows of a frame as scrolling the terminal would
+static void apply_scroll(frame_t *me, scroll_t scroll) {
+  assert(me != NULL);
+  assert(scroll.top <= scroll.bottom);
+  assert(scroll.bottom < me->rows);
+
+  const size_t distance =
+      (size_t)(scroll.shift < 0 ? -scroll.shift : scroll.shift);
+  assert(distance <= scroll.bottom - scroll.top);
+  const size_t kept = scroll.bottom - scroll.top + 1 - distance;
+
+  // which rows move, and which are left blank?
+  const size_t from = scroll.shift > 0 ? scroll.top + distance : scroll.top;
+  const size_t to = scroll.shift > 0 ? scroll.top : scroll.top + distance;
+  const size_t blank = scroll.shift > 0 ? scroll.top + kept : scroll.top;
+
+  memmove(&me->cells[to * me->columns], &me->cells[from * me->columns],
+          kept * me->columns * sizeof(me->cells[0]));
+  memmove(&me->hashes[to], &me->hashes[from], kept * sizeof(me->hashes[0]));
+
+  for (size_t i = blank * me->columns; i < (blank + distance) * me->columns;
+       ++i)
+    me->cells[i] = GLYPH_BLANK;
+  for (size_t i = blank; i < blank + distance; ++i)
+    me->hashes[i] = 0;
+}
+
+/// maximum number of separate regions to scroll in a single update
+enum { MAX_SCROLLS = 4 };
+
+int frame_scroll(buffer_t *out, frame_t *front, const frame_t *back) {
+  assert(out != NULL);
+  assert(front != NULL);
+  assert(back != NULL);
+  assert(front->rows == back->rows);
+  assert(front->columns == back->columns);
+  assert(front->glyphs == back->glyphs);
+
+  // scrolling can only help if several rows have changed
+  size_t changed = 0;
+  for (size_t y = 0; y < back->rows && changed < 2; ++y) {
+    if (front->hashes[y] != back->hashes[y])
+      ++changed;
+  }
+  if (changed < 2)
+    return 0;
+
+  row_key_t *keys = NULL;
+  size_t *votes = NULL;
+  int rc = 0;
+
+  keys = malloc(back->rows * sizeof(keys[0]));
+  votes = malloc(2 * back->rows * sizeof(votes[0]));
+  if (keys == NULL || votes == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  for (size_t i = 0; i < MAX_SCROLLS; ++i) {
+    scroll_t scroll;
+    if (!find_scroll(front, back, keys, votes, &scroll))
+      break;
+
+    // Restrict scrolling to the region, and then move content up by indexing
+    // (IND) from its bottom or down by reverse indexing (RI) from its top.
+    // These date back to the VT100, so are more widely supported than SU/SD.
+    if ((rc = buffer_append(out, "\033[", 2)))
+      goto done;
+    if ((rc = buffer_append_num(out, scroll.top + 1)))
+      goto done;
+    if ((rc = buffer_append(out, ";", 1)))
+      goto done;
+    if ((rc = buffer_append_num(out, scroll.bottom + 1)))
+      goto done;
+    if ((rc = buffer_append(out, "r", 1)))
+      goto done;
+    if ((rc = move(out, 0, scroll.shift > 0 ? scroll.bottom : scroll.top)))
+      goto done;
+    const size_t distance =
+        (size_t)(scroll.shift < 0 ? -scroll.shift : scroll.shift);
+    for (size_t j = 0; j < distance; ++j) {
+      if ((rc = buffer_append(out, scroll.shift > 0 ? "\033D" : "\033M", 2)))
+        goto done;
+    }
+
+    // restore the full screen as the scrolling region
+    if ((rc = buffer_append(out, "\033[r", 3)))
+      goto done;
+
+    apply_scroll(front, scroll);
+  }
+
+done:
+  free(votes);
+  free(keys);
+
+  return rc;
+}
+
+int frame_diff(buffer_t *out, const frame_t *front, const frame_t *back,
+               bool rep, bool ech) {
+  assert(out != NULL);
+  assert(front != NULL);
+  assert(back != NULL);
+  assert(front->rows == back->rows);
+  assert(front->columns == back->columns);
+  assert(front->glyphs == back->glyphs);
+
+  // where the terminal’s cursor is, if known
+  bool known = false;
+  size_t cursor_x = 0;
+  size_t cursor_y = 0;
+
+  for (size_t y = 0; y < back->rows; ++y) {
+
+    // skip rows that are unchanged
+    if (front->hashes[y] == back->hashes[y])
+      continue;
+
+    const glyph_t *const f = &front->cells[y * front->columns];
+    const glyph_t *const b = &back->cells[y * back->columns];
+
+    for (size_t x = 0; x < back->columns;) {
+
+      // skip cells that are unchanged
+      x += scan_mismatch(&f[x], &b[x], back->columns - x);
+      if (x == back->columns)
+        break;
+
+      // covered cells are drawn along with the wide cell covering them
+      if (b[x] == GLYPH_COVERED) {
+        ++x;
+        continue;
+      }
+
+      int rc = 0;
+
+      if (!known || cursor_y != y || cursor_x != x) {
+
+        // choose the cheapest way of getting the cursor here
+        size_t best = move_cost(x, y);
+        enum { CUP, CUF, REDRAW } how = CUP;
+
+        if (known && cursor_y == y && cursor_x < x) {
+          if (csi_cost(x - cursor_x) < best) {
+            best = csi_cost(x - cursor_x);
+            how = CUF;
+          }
+
+          // it may be cheaper still to redraw the unchanged cells in between
+          size_t gap = 0;
+          for (size_t i = cursor_x; i < x && gap < best; ++i)
+            gap += cost(back, b[i]);
+          if (gap < best)
+            how = REDRAW;
+        }
+
+        if (how == REDRAW) {
+          for (size_t i = cursor_x; i < x; ++i) {
+            if ((rc = draw(out, back, b[i])))
+              return rc;
+          }
+        } else if (how == CUF) {
+          if ((rc = csi(out, x - cursor_x, 'C')))
+            return rc;
+        } else if ((rc = move(out, x, y))) {
+          return rc;
+        }
+      }
+
+      // measure the run of identical cells starting here
+      const size_t run = scan_run(&b[x], back->columns - x, b[x]);
+
+      // a blank run to the end of the row can be erased with EL
+      if (b[x] == GLYPH_BLANK && x + run == back->columns && run > 3) {
+        if ((rc = buffer_append(out, "\033[K", 3)))
+          return rc;
+        known = true;
+        cursor_x = x;
+        cursor_y = y;
+        x += run;
+        continue;
+      }
+
+      // other blank runs can be erased with ECH, which leaves the cursor put
+      if (ech && b[x] == GLYPH_BLANK && run > csi_cost(run)) {
+        if ((rc = csi(out, run, 'X')))
+          return rc;
+        known = true;
+        cursor_x = x;
+        cursor_y = y;
+        x += run;
+        continue;
+      }
+
+      const glyph_info_t *const g = glyphs_get(back->glyphs, b[x]);
+      if ((rc = buffer_append(out, g->text, g->len)))
+        return rc;
+
+      // repeat the cell if doing so is cheaper than writing it out again
+      if (rep && run > 1 && g->repeatable &&
+          (run - 1) * g->len > csi_cost(run - 1)) {
+        if ((rc = csi(out, run - 1, 'b')))
+          return rc;
+        x += run - 1;
+      }
+
+      x += g->width;
+      known = true;
+      cursor_x = x;
+      cursor_y = y;
+    }
+  }
+
+  return 0;
+}
+
+void frame_free(frame_t *me) {
+
+  if (me == NULL)
+    return;
+
+  free(me->cells);
+  free(me->hashes);
+  *me = (frame_t){0};
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "buffer.h"
+#include "glyph.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// a grid of terminal cells
+///
+/// Each cell holds a glyph: a single grapheme cluster, along with any escape
+/// sequences (e.g. SGR attributes) that were in effect when it was written.
+/// These are followed by a reset when necessary, so every cell can be written
+/// to the terminal independently of its neighbours.
+///
+/// Frames that are compared against each other share a glyph table, so their
+/// cells can be compared as integers.
+typedef struct {
+  size_t rows;
+  size_t columns;
+  glyph_t *cells;   ///< `rows` × `columns` cells, row-major
+  glyphs_t *glyphs; ///< table the cells’ glyphs are interned in
+
+  /// hash of each row’s cells, maintained as cells are written
+  ///
+  /// Rows of frames sharing a glyph table hash equally if they hold the same
+  /// cells. Rows that hash equally are assumed to be the same, with a chance of
+  /// a collision too small to worry about.
+  uint64_t *hashes;
+} frame_t;
+
+/// create a blank frame
+///
+/// \param me [out] Frame to initialise
+/// \param glyphs Table to intern the frame’s glyphs in
+/// \param rows Height of the frame
+/// \param columns Width of the frame
+/// \return 0 on success or an errno on failure
+int frame_new(frame_t *me, glyphs_t *glyphs, size_t rows, size_t columns);
+
+/// write text into a frame
+///
+/// The text is split into grapheme clusters, each occupying as many cells as
+/// its display width. Text that extends beyond the right edge of the frame is
+/// discarded.
+///
+/// \param me Frame to write to
+/// \param x Column at which to begin the write, 0-based
+/// \param y Row at which to begin the write, 0-based
+/// \param text Text to write
+/// \param len Number of bytes in `text`
+/// \return 0 on success or an errno on failure
+int frame_put(frame_t *me, size_t x, size_t y, const char *text, size_t len);
+
+/// a cell prepared in advance for writing into frames
+///
+/// This avoids the cost of splitting and encoding text that is written
+/// repeatedly, as well as that of interning it each time it is written into
+/// frames sharing a glyph table.
+typedef struct {
+  const char *bytes; ///< content as it would be interned, `NULL` if blank
+  uint16_t len;      ///< number of bytes in `bytes`
+  uint8_t width;     ///< columns occupied
+
+  /// `serial` of the glyph table this cell was most recently interned in, and
+  /// the resulting glyph, unused for blank cells
+  uint64_t serial;
+  glyph_t glyph;
+} encoded_t;
+
+/// write prepared cells into a frame
+///
+/// This is equivalent to writing the text the cells were prepared from with
+/// `frame_put`.
+///
+/// \param me Frame to write to
+/// \param x Column at which to begin the write, 0-based
+/// \param y Row at which to begin the write, 0-based
+/// \param cells Cells to write, whose cached glyphs are updated
+/// \param n Number of entries in `cells`
+/// \return 0 on success or an errno on failure
+int frame_put_encoded(frame_t *me, size_t x, size_t y, encoded_t *cells,
+                      size_t n);
+
+/// blank every cell of a frame
+void frame_clear(frame_t *me);
+
+/// copy one frame over another of the same dimensions and glyph table
+///
+/// \param dst Frame to overwrite
+/// \param src Frame to copy
+void frame_copy(frame_t *dst, const frame_t *src);
+
+/// copy a row of one frame into part of a row of another
+///
+/// Cells that fall beyond the right edge of `dst` are discarded, as is a wide
+/// cell that would straddle it. Wide cells of `dst` partially overwritten by
+/// the copy are erased.
+///
+/// \param dst Frame to write to
+/// \param x Column of `dst` at which to place the row, 0-based
+/// \param y Row of `dst` to write, 0-based
+/// \param src Frame to copy from, sharing a glyph table with `dst`
+/// \param src_y Row of `src` to copy, 0-based
+void frame_blit(frame_t *dst, size_t x, size_t y, const frame_t *src,
+                size_t src_y);
+
+/// rebuild a glyph table, retaining only the glyphs some frames use
+///
+/// Any other frames sharing the table must not be used again until they have
+/// been cleared or overwritten.
+///
+/// \param frames Frames whose glyphs to keep, all sharing a single table
+/// \param n Number of entries in `frames`
+/// \return 0 on success or an errno on failure
+int frame_compact(frame_t *const *frames, size_t n);
+
+/// scroll regions of the terminal to reuse rows that have moved
+///
+/// Rows of the frame to display that are already on the terminal in a
+/// different position, e.g. in a scrolling log, are moved into place by
+/// scrolling rather than being redrawn. The scrolling is applied to `front`,
+/// so it continues to reflect what the terminal is displaying, ready to be
+/// passed to `frame_diff`. Nothing is written if no scroll is worthwhile.
+///
+/// \param out Buffer to append terminal output to
+/// \param front Frame currently displayed on the terminal
+/// \param back Frame to display
+/// \return 0 on success or an errno on failure
+int frame_scroll(buffer_t *out, frame_t *front, const frame_t *back);
+
+/// generate the output needed to change the terminal from one frame to another
+///
+/// Rows whose hashes match are skipped without comparing their cells. Runs of
+/// identical cells are compressed using the given control sequences, where
+/// that is shorter than writing them out.
+///
+/// \param out Buffer to append terminal output to
+/// \param front Frame currently displayed on the terminal
+/// \param back Frame to display
+/// \param rep Can REP be used to repeat characters?
+/// \param ech Can ECH be used to erase characters?
+/// \return 0 on success or an errno on failure
+int frame_diff(buffer_t *out, const frame_t *front, const frame_t *back,
+               bool rep, bool ech);
+
+/// deallocate the backing memory of a frame
+void frame_free(frame_t *me);
@@ -0,0 +1,248 @@
+#include "glyph.h"
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// source of glyph table serials
+static uint64_t next_serial = 1;
+static pthread_mutex_t next_serial_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/// minimum size of a block of glyph bytes
+enum { BLOCK_SIZE = 65536 };
+
+/// find which chunk, and where within it, a glyph is stored
+static void locate(glyph_t glyph, size_t *chunk, size_t *offset) {
+  assert(chunk != NULL);
+  assert(offset != NULL);
+
+  const uint64_t v = (uint64_t)glyph + 256;
+  size_t k = 0;
+  while ((v >> (k + 9)) != 0)
+    ++k;
+  *chunk = k;
+  *offset = (size_t)(v - ((uint64_t)256 << k));
+}
+
+const glyph_info_t *glyphs_get(const glyphs_t *me, glyph_t glyph) {
+  assert(me != NULL);
+
+  // `n` is not checked, as the writer thread may call this while the main
+  // thread is interning
+  size_t chunk, offset;
+  locate(glyph, &chunk, &offset);
+  return &me->chunks[chunk][offset];
+}
+
+/// FNV-1a
+static uint32_t hash(const char *text, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; ++i) {
+    h ^= (unsigned char)text[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/// is this a single, narrow character without escape sequences?
+///
+/// REP repeats the last graphic character with the current attributes, so only
+/// such glyphs can be repeated with it.
+static bool repeatable(const char *text, size_t len, size_t width) {
+  if (width != 1 || len == 0)
+    return false;
+
+  const unsigned char lead = (unsigned char)text[0];
+  if (lead < 0x80)
+    return len == 1 && lead >= 0x20;
+  if ((lead >> 5) == 6)
+    return len == 2;
+  if ((lead >> 4) == 14)
+    return len == 3;
+  if ((lead >> 3) == 30)
+    return len == 4;
+  return false;
+}
+
+/// copy bytes into the table’s storage
+static int store(glyphs_t *me, const char *text, size_t len,
+                 const char **stored) {
+  assert(me != NULL);
+  assert(stored != NULL);
+
+  // do we need a new block?
+  if (me->n_blocks == 0 || me->block_size - me->block_used < len) {
+    const size_t size = len > BLOCK_SIZE ? len : BLOCK_SIZE;
+
+    char **const bs =
+        realloc(me->blocks, (me->n_blocks + 1) * sizeof(me->blocks[0]));
+    if (bs == NULL)
+      return ENOMEM;
+    me->blocks = bs;
+
+    char *const b = malloc(size);
+    if (b == NULL)
+      return ENOMEM;
+    me->blocks[me->n_blocks] = b;
+    ++me->n_blocks;
+    me->block_used = 0;
+    me->block_size = size;
+  }
+
+  char *const dst = &me->blocks[me->n_blocks - 1][me->block_used];
+  if (len > 0)
+    memcpy(dst, text, len);
+  me->block_used += len;
+  *stored = dst;
+
+  return 0;
+}
+
+/// place a glyph into the hash index, which must have a free slot
+static void insert(glyphs_t *me, glyph_t glyph, uint32_t h) {
+  assert(me != NULL);
+  assert(me->c_index > 0);
+
+  const size_t mask = me->c_index - 1;
+  size_t i = h & mask;
+  while (me->index[i] != GLYPH_BLANK)
+    i = (i + 1) & mask;
+  me->index[i] = glyph;
+}
+
+/// double the size of the hash index
+static int grow(glyphs_t *me) {
+  assert(me != NULL);
+
+  const size_t c = me->c_index == 0 ? 1024 : me->c_index * 2;
+  glyph_t *const index = calloc(c, sizeof(index[0]));
+  if (index == NULL)
+    return ENOMEM;
+
+  glyph_t *const old = me->index;
+  const size_t c_old = me->c_index;
+  me->index = index;
+  me->c_index = c;
+
+  for (size_t i = 0; i < c_old; ++i) {
+    if (old[i] != GLYPH_BLANK)
+      insert(me, old[i], glyphs_get(me, old[i])->hash);
+  }
+  free(old);
+
+  return 0;
+}
+
+/// append a glyph to the table, without indexing it
+static int append(glyphs_t *me, glyph_info_t info) {
+  assert(me != NULL);
+
+  if (me->n == UINT32_MAX)
+    return ENOMEM;
+
+  size_t chunk, offset;
+  locate(me->n, &chunk, &offset);
+  if (chunk >= GLYPH_CHUNKS)
+    return ENOMEM;
+
+  if (me->chunks[chunk] == NULL) {
+    me->chunks[chunk] = malloc(((size_t)256 << chunk) * sizeof(info));
+    if (me->chunks[chunk] == NULL)
+      return ENOMEM;
+  }
+
+  me->chunks[chunk][offset] = info;
+  ++me->n;
+
+  return 0;
+}
+
+int glyphs_new(glyphs_t *me) {
+  assert(me != NULL);
+
+  *me = (glyphs_t){0};
+  int rc = 0;
+
+  (void)pthread_mutex_lock(&next_serial_lock);
+  me->serial = next_serial++;
+  (void)pthread_mutex_unlock(&next_serial_lock);
+
+  // blank cells are displayed as a space
+  const glyph_info_t blank = {
+      .text = " ", .len = 1, .width = 1, .repeatable = true};
+  if ((rc = append(me, blank)))
+    goto done;
+
+  // covered cells are displayed by the cell covering them
+  const glyph_info_t covered = {.text = ""};
+  if ((rc = append(me, covered)))
+    goto done;
+
+done:
+  if (rc != 0)
+    glyphs_free(me);
+
+  return rc;
+}
+
+int glyphs_intern(glyphs_t *me, const char *text, size_t len, size_t width,
+                  glyph_t *glyph) {
+  assert(me != NULL);
+  assert(text != NULL || len == 0);
+  assert(glyph != NULL);
+
+  if (len > UINT16_MAX || width > UINT8_MAX)
+    return ERANGE;
+
+  const uint32_t h = hash(text, len);
+
+  // is this glyph already known?
+  if (me->c_index > 0) {
+    const size_t mask = me->c_index - 1;
+    for (size_t i = h & mask; me->index[i] != GLYPH_BLANK;
+         i = (i + 1) & mask) {
+      const glyph_info_t *const g = glyphs_get(me, me->index[i]);
+      if (g->hash == h && g->len == len && memcmp(g->text, text, len) == 0) {
+        *glyph = me->index[i];
+        return 0;
+      }
+    }
+  }
+
+  // keep the index at most half full
+  int rc = 0;
+  if (2 * ((size_t)me->n + 1) > me->c_index) {
+    if ((rc = grow(me)))
+      return rc;
+  }
+
+  glyph_info_t info = {.hash = h,
+                       .len = (uint16_t)len,
+                       .width = (uint8_t)width,
+                       .repeatable = repeatable(text, len, width)};
+  if ((rc = store(me, text, len, &info.text)))
+    return rc;
+  if ((rc = append(me, info)))
+    return rc;
+
+  *glyph = me->n - 1;
+  insert(me, *glyph, h);
+
+  return 0;
+}
+
+void glyphs_free(glyphs_t *me) {
+  assert(me != NULL);
+
+  for (size_t i = 0; i < GLYPH_CHUNKS; ++i)
+    free(me->chunks[i]);
+  for (size_t i = 0; i < me->n_blocks; ++i)
+    free(me->blocks[i]);
+  free(me->blocks);
+  free(me->index);
+  *me = (glyphs_t){0};
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// an identifier for the content of a terminal cell
+///
+/// Two cells display identically if and only if they hold the same glyph, so
+/// cells can be compared without looking at their bytes.
+typedef uint32_t glyph_t;
+
+/// a cell containing nothing
+#define GLYPH_BLANK ((glyph_t)0)
+
+/// a cell covered by a wide cell to its left
+#define GLYPH_COVERED ((glyph_t)1)
+
+/// the content behind a glyph
+typedef struct {
+  const char *text; ///< bytes to write to display this glyph
+  uint32_t hash;    ///< hash of `text`
+  uint16_t len;     ///< number of bytes in `text`
+  uint8_t width;    ///< columns occupied
+  bool repeatable;  ///< can this be repeated with REP?
+} glyph_info_t;
+
+/// number of storage chunks in a glyph table
+///
+/// Chunk `k` holds 256 << k glyphs, so this many chunks covers every `glyph_t`.
+#define GLYPH_CHUNKS 24
+
+/// a table interning distinct cell contents
+///
+/// Each distinct sequence of bytes (a grapheme cluster along with any escape
+/// sequences applying to it) is stored once and thereafter referred to by its
+/// `glyph_t`. Glyphs are never removed, except by discarding the whole table.
+///
+/// Glyphs never move once interned. So a thread that has been handed a frame
+/// may look up the glyphs it contains while another thread interns new ones.
+typedef struct {
+  /// identifier distinguishing this table from every other one created
+  ///
+  /// Callers caching glyphs can use this to determine whether their cache
+  /// applies to a given table. A table that has been freed and recreated gets a
+  /// new serial. 0 is never used.
+  uint64_t serial;
+
+  glyph_info_t *chunks[GLYPH_CHUNKS];
+  uint32_t n; ///< number of glyphs interned, including the reserved ones
+
+  /// storage for the bytes of glyphs
+  ///
+  /// Bytes are bump allocated from the most recent block. Full blocks are kept
+  /// until the table is freed.
+  char **blocks;
+  size_t n_blocks;
+  size_t block_used; ///< bytes used in the most recent block
+  size_t block_size; ///< bytes available in the most recent block
+
+  /// open addressed hash table of glyphs, by their `text`
+  ///
+  /// Empty slots contain `GLYPH_BLANK`, which is itself never looked up.
+  glyph_t *index;
+  size_t c_index; ///< number of slots in `index`, a power of 2
+} glyphs_t;
+
+/// create an empty glyph table
+///
+/// \param me [out] Table to initialise
+/// \return 0 on success or an errno on failure
+int glyphs_new(glyphs_t *me);
+
+/// find or add a glyph
+///
+/// \param me Table to search
+/// \param text Bytes of the glyph
+/// \param len Number of bytes in `text`
+/// \param width Number of columns the glyph occupies
+/// \param glyph [out] Identifier of the glyph
+/// \return 0 on success or an errno on failure
+int glyphs_intern(glyphs_t *me, const char *text, size_t len, size_t width,
+                  glyph_t *glyph);
+
+/// look up the content of a glyph
+///
+/// \param me Table the glyph was interned into
+/// \param glyph Glyph to look up
+/// \return Content of the glyph
+const glyph_info_t *glyphs_get(const glyphs_t *me, glyph_t glyph);
+
+/// deallocate the backing memory of a glyph table
+void glyphs_free(glyphs_t *me);
@@ -1,13 +1,20 @@
 #include "input.h"
+#include "buffer.h"
+#include "clock.h"
+#include "probe.h"
+#include "record.h"
 #include <assert.h>
 #include <endgame/event.h>
 #include <endgame/input.h>
 #include <errno.h>
 #include <poll.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 int eg_input_new(eg_input_t **me, FILE *in) {
@@ -45,25 +52,219 @@ done:
   return rc;
 }
 
+int eg_input_replay_new(eg_input_t **me, FILE *log, bool realtime) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (log == NULL)
+    return EINVAL;
+
+  *me = NULL;
+  eg_input_t *i = NULL;
+  int rc = 0;
+
+  i = calloc(1, sizeof(*i));
+  if (i == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  i->replay = log;
+  i->realtime = realtime;
+
+  if ((rc = record_open(log)))
+    goto done;
+
+  // the first event is timed relative to the start of replay
+  i->last = now_ms();
+
+  *me = i;
+  i = NULL;
+
+done:
+  eg_input_free(&i);
+
+  return rc;
+}
+
+int input_unread(eg_input_t *me, const char *data, size_t len) {
+  assert(me != NULL);
+  assert(data != NULL || len == 0);
+
+  // compact what has already been consumed, so the buffer does not grow
+  // without bound
+  if (me->unread_off == me->unread.len) {
+    buffer_reset(&me->unread);
+    me->unread_off = 0;
+  }
+
+  return buffer_append(&me->unread, data, len);
+}
+
+bool input_pending(const eg_input_t *me) {
+  assert(me != NULL);
+  return me->unread_off < me->unread.len;
+}
+
+/// take up to `len` pushed back bytes
+///
+/// \return Number of bytes taken
+static size_t take_unread(eg_input_t *me, unsigned char *dst, size_t len) {
+  assert(me != NULL);
+  assert(dst != NULL);
+
+  const size_t avail = me->unread.len - me->unread_off;
+  const size_t n = len < avail ? len : avail;
+  memcpy(dst, &me->unread.data[me->unread_off], n);
+  me->unread_off += n;
+
+  return n;
+}
+
+/// discard replies to a probe from the front of the input
+///
+/// \param me Input that may be receiving replies
+/// \return 0 on success or an errno on failure
+static int discard_replies(eg_input_t *me) {
+  assert(me != NULL);
+  assert(me->unanswered);
+
+  int rc = 0;
+
+  // gather everything the terminal has sent so far, so replies are seen whole
+  struct pollfd in = {.fd = fileno(me->in), .events = POLLIN};
+  while (poll(&in, 1, 0) > 0) {
+    char buffer[256];
+    const ssize_t r = read(in.fd, buffer, sizeof(buffer));
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno;
+    }
+    if (r == 0) { // the terminal has gone, so will not reply
+      me->unanswered = false;
+      break;
+    }
+    if ((rc = input_unread(me, buffer, (size_t)r)))
+      return rc;
+    if ((size_t)r < sizeof(buffer))
+      break;
+  }
+
+  while (me->unanswered && input_pending(me)) {
+    bool last;
+    const size_t n = probe_reply(&me->unread.data[me->unread_off],
+                                 me->unread.len - me->unread_off, &last);
+    if (n == 0)
+      break;
+    me->unread_off += n;
+    if (last)
+      me->unanswered = false;
+  }
+
+  return 0;
+}
+
+/// read ahead the next event from a recorded session, if not already done
+static void peek(eg_input_t *me) {
+  assert(me != NULL);
+  assert(me->replay != NULL);
+
+  if (me->peeked)
+    return;
+
+  uint64_t delay = 0;
+  eg_event_t event = {0};
+  const int rc = record_read(me->replay, &delay, &event);
+  if (rc != 0) {
+    event = (eg_event_t){EG_EVENT_ERROR, (uint32_t)rc};
+    delay = 0;
+  }
+
+  me->next = event;
+  me->due = me->last + delay;
+  me->peeked = true;
+}
+
+uint64_t input_replay_left(eg_input_t *me, uint64_t now) {
+  assert(me != NULL);
+  assert(me->replay != NULL);
+
+  if (!me->realtime)
+    return 0;
+
+  peek(me);
+
+  return me->due > now ? me->due - now : 0;
+}
+
+/// get the next event from a recorded session
+static eg_event_t replay(eg_input_t *me) {
+  assert(me != NULL);
+  assert(me->replay != NULL);
+
+  peek(me);
+
+  if (me->realtime) {
+    for (uint64_t t = now_ms(); t < me->due; t = now_ms()) {
+      const uint64_t wait = me->due - t;
+      const struct timespec ts = {.tv_sec = (time_t)(wait / 1000),
+                                  .tv_nsec = (long)(wait % 1000) * 1000000};
+      (void)nanosleep(&ts, NULL);
+    }
+    me->last = me->due;
+  }
+
+  me->peeked = false;
+  return me->next;
+}
+
 eg_event_t eg_input_read(eg_input_t *me, int tick) {
 
   if (me == NULL)
     return (eg_event_t){EG_EVENT_ERROR, EINVAL};
 
+  if (me->replay != NULL)
+    return replay(me);
+
   // wait until we have some data on stdin or from the signal bouncer
   struct pollfd in[] = {{.fd = fileno(me->in), .events = POLLIN},
                         /* {.fd = signal_pipe[0], .events = POLLIN}*/};
-  {
-    nfds_t nfds = sizeof(in) / sizeof(in[0]);
-    while (true) {
-      const int r = poll(in, nfds, tick);
-      if (r > 0)
-        break;
-      if (r == 0)
-        return (eg_event_t){.type = EG_EVENT_TICK};
-      if (errno == EINTR)
-        continue;
-      return (eg_event_t){EG_EVENT_ERROR, (uint32_t)errno};
+  const uint64_t start = now_ms();
+  bool pending;
+  while (true) {
+    pending = input_pending(me);
+    if (!pending) {
+      nfds_t nfds = sizeof(in) / sizeof(in[0]);
+      while (true) {
+        // time spent discarding replies counts against the tick
+        int wait = tick;
+        if (tick > 0) {
+          const uint64_t elapsed = now_ms() - start;
+          wait = elapsed >= (uint64_t)tick ? 0 : tick - (int)elapsed;
+        }
+        const int r = poll(in, nfds, wait);
+        if (r > 0)
+          break;
+        if (r == 0)
+          return (eg_event_t){.type = EG_EVENT_TICK};
+        if (errno == EINTR)
+          continue;
+        return (eg_event_t){EG_EVENT_ERROR, (uint32_t)errno};
+      }
+    }
+
+    if (!me->unanswered)
+      break;
+
+    // late replies to a probe are not key presses
+    const int rc = discard_replies(me);
+    if (rc != 0)
+      return (eg_event_t){EG_EVENT_ERROR, (uint32_t)rc};
+    if (input_pending(me)) {
+      pending = true;
+      break;
     }
   }
 
@@ -91,13 +292,16 @@ eg_event_t eg_input_read(eg_input_t *me, int tick) {
   }
 #endif
 
-  assert(in[0].revents & POLLIN);
+  assert(pending || (in[0].revents & POLLIN));
 
-  // priority 3: read a character from stdin
+  // priority 3: read a character from what we pushed back or stdin
   unsigned char buffer[4] = {
       0}; // enough for a UTF-8 character or escape sequence
-  if (read(fileno(me->in), &buffer, 1) < 0)
+  if (pending) {
+    (void)take_unread(me, buffer, 1);
+  } else if (read(fileno(me->in), &buffer, 1) < 0) {
     return (eg_event_t){EG_EVENT_ERROR, errno};
+  }
 
   // is this a multi-byte sequence?
   size_t more = 0;
@@ -112,12 +316,14 @@ eg_event_t eg_input_read(eg_input_t *me, int tick) {
   }
 
   if (more > 0) {
+    assert(more <= sizeof(buffer) / sizeof(buffer[0]) - 1);
+    const size_t got = pending ? take_unread(me, &buffer[1], more) : 0;
+
     // does stdin have remaining ready data?
     struct pollfd input[] = {{.fd = fileno(me->in), .events = POLLIN}};
     nfds_t nfds = sizeof(input) / sizeof(input[0]);
-    if (poll(input, nfds, 0) > 0) {
-      assert(more <= sizeof(buffer) / sizeof(buffer[0]) - 1);
-      ssize_t ignored = read(fileno(me->in), &buffer[1], more);
+    if (got < more && !input_pending(me) && poll(input, nfds, 0) > 0) {
+      ssize_t ignored = read(fileno(me->in), &buffer[1 + got], more - got);
       (void)ignored;
     }
   }
@@ -137,6 +343,7 @@ void eg_input_free(eg_input_t **me) {
   if (*me == NULL)
     return;
 
+  buffer_free(&(*me)->unread);
   free(*me);
   *me = NULL;
 }
@@ -1,8 +1,53 @@
 #pragma once
 
+#include "buffer.h"
+#include <endgame/event.h>
 #include <endgame/input.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 struct eg_input {
   FILE *in; ///< input handle to the TTY
+
+  /// bytes to return before reading any more from `in`
+  ///
+  /// These are keys the user pressed while the terminal was being probed,
+  /// which arrive interleaved with its replies.
+  buffer_t unread;
+  size_t unread_off; ///< how much of `unread` has been returned already
+
+  /// might the terminal still reply to a probe that timed out?
+  ///
+  /// Until the final reply arrives, replies are discarded instead of being
+  /// returned as key presses.
+  bool unanswered;
+
+  FILE *replay;  ///< event log to read from instead, if any
+  bool realtime; ///< should replay wait out the delays between events?
+  uint64_t last; ///< time (ms) the last replayed event was due
+
+  /// the next replayed event, read ahead to learn when it is due
+  bool peeked;     ///< is `next` valid?
+  eg_event_t next; ///< event to return next
+  uint64_t due;    ///< time (ms) `next` is due, if `realtime`
 };
+
+/// push bytes back onto the input, to be returned before any others
+///
+/// \param me Input to push onto
+/// \param data Bytes to push
+/// \param len Number of bytes in `data`
+/// \return 0 on success or an errno on failure
+int input_unread(eg_input_t *me, const char *data, size_t len);
+
+/// are there pushed back bytes yet to be read?
+bool input_pending(const eg_input_t *me);
+
+/// how long until the next replayed event is due
+///
+/// \param me Replaying input to examine
+/// \param now Current time in ms
+/// \return Milliseconds until `eg_input_read` will return without waiting
+uint64_t input_replay_left(eg_input_t *me, uint64_t now);
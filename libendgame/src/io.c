@@ -1,17 +1,50 @@
 #include "io.h"
+#include "buffer.h"
+#include "clock.h"
+#include "frame.h"
+#include "input.h"
+#include "output.h"
+#include "record.h"
+#include "timer.h"
 #include <assert.h>
 #include <endgame/event.h>
 #include <endgame/input.h>
 #include <endgame/io.h>
 #include <endgame/output.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <unistd.h>
 
+/// pass on input that arrived while probing the terminal
+///
+/// The input is also told whether replies to the probe may yet arrive, so it
+/// can discard them rather than report them as key presses.
+///
+/// \param in Input to return the stray bytes from
+/// \param out Output that was just probed
+/// \return 0 on success or an errno on failure
+static int take_stray(eg_input_t *in, eg_output_t *out) {
+  assert(in != NULL);
+  assert(out != NULL);
+
+  int rc = 0;
+
+  // a replay has no use for live key presses
+  if (in->replay == NULL) {
+    if ((rc = input_unread(in, out->stray.data, out->stray.len)))
+      return rc;
+    in->unanswered = out->unanswered;
+  }
+  buffer_reset(&out->stray);
+
+  return 0;
+}
+
 int eg_io_new(eg_io_t **me, FILE *in, FILE *out) {
 
   if (me == NULL)
@@ -36,7 +69,11 @@ int eg_io_new(eg_io_t **me, FILE *in, FILE *out) {
   if ((rc = eg_input_new(&i->in, in)))
     goto done;
 
-  if ((rc = eg_output_new(&i->out, out)))
+  // the terminal replies to probing on our input
+  if ((rc = output_new(&i->out, out, fileno(in))))
+    goto done;
+
+  if ((rc = take_stray(i->in, i->out)))
     goto done;
 
   *me = i;
@@ -63,6 +100,10 @@ int eg_io_attach(eg_io_t **me, eg_input_t *in, eg_output_t *out) {
   eg_io_t *i = NULL;
   int rc = 0;
 
+  // keys pressed while `out` was probing belong to `in`
+  if ((rc = take_stray(in, out)))
+    goto done;
+
   i = calloc(1, sizeof(*i));
   if (i == NULL) {
     rc = ENOMEM;
@@ -91,56 +132,238 @@ int eg_io_set_tick(eg_io_t *me, int tick) {
   return 0;
 }
 
-/// convert a timespec to milliseconds
-static uint64_t ts2ms(struct timespec ts) {
-  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+int eg_io_set_idle(eg_io_t *me, bool idle) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  me->idle = idle;
+
+  return 0;
 }
 
-/// get the current time in milliseconds
-static int get_time(uint64_t *ms) {
-  assert(ms != NULL);
-  struct timespec ts = {0};
-  if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
-    return errno;
-  *ms = ts2ms(ts);
+int eg_io_record(eg_io_t *me, FILE *log) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  me->record = NULL;
+
+  if (log == NULL)
+    return 0;
+
+  int rc = 0;
+  if ((rc = record_start(log)))
+    return rc;
+
+  me->last_record = now_ms();
+
+  me->record = log;
+
   return 0;
 }
 
-eg_event_t eg_io_read(eg_io_t *me) {
+int eg_io_add_timer(eg_io_t *me, uint32_t delay, uint32_t period,
+                    uint32_t tag, eg_timer_handle_t *handle) {
 
   if (me == NULL)
-    return (eg_event_t){EG_EVENT_ERROR, EINVAL};
+    return EINVAL;
+
+  // bring the wheel up to date, so the delay counts from now
+  timers_advance(&me->timers, now_ms());
+  int rc = 0;
+
+  eg_timer_handle_t h;
+  if ((rc = timers_add(&me->timers, delay, period, tag, &h)))
+    return rc;
+
+  if (handle != NULL)
+    *handle = h;
+
+  return 0;
+}
+
+int eg_io_cancel_timer(eg_io_t *me, eg_timer_handle_t handle) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return timers_cancel(&me->timers, handle);
+}
+
+/// how long to wait for input before a tick or timer is due
+///
+/// \param me I/O device to examine
+/// \param now Current time in ms
+/// \return Milliseconds to wait, 0 if one is already due, or -1 for no limit
+static int time_left(eg_io_t *me, uint64_t now) {
+  assert(me != NULL);
 
   // default to tickless
-  int tick = -1;
+  int timeout = -1;
 
-  // if this device is tickfull and ≥ a tick has passed, yield that
-  if (me->tick > 0) {
-    uint64_t now;
-    const int err = get_time(&now);
-    if (err != 0)
-      return (eg_event_t){EG_EVENT_ERROR, err};
-    if (now - me->last_tick >= (uint64_t)me->tick) {
+  // if < a tick has passed, we want to account for this slice
+  if (me->tick > 0 && !me->idle) {
+    const uint64_t since = now - me->last_tick;
+    timeout = since >= (uint64_t)me->tick ? 0 : me->tick - (int)since;
+  }
+
+  // wait no longer than until the next timer
+  timers_advance(&me->timers, now);
+  uint64_t due;
+  if (timers_next(&me->timers, &due)) {
+    const uint64_t wait = due > now ? due - now : 0;
+    if (timeout < 0 || wait < (uint64_t)timeout)
+      timeout = wait > INT_MAX ? INT_MAX : (int)wait;
+  }
+
+  return timeout;
+}
+
+/// `eg_io_read` minus recording
+///
+/// \param me I/O device to read from
+/// \param block Whether to wait for an event if none is ready
+/// \return Event seen, or an `EAGAIN` error if not blocking and none was ready
+static eg_event_t next_event(eg_io_t *me, bool block) {
+  assert(me != NULL);
+
+  // a replay already contains its ticks and timers, but may need to wait out
+  // the recorded delay before the next
+  if (me->in->replay != NULL) {
+    if (!block && input_replay_left(me->in, now_ms()) > 0)
+      return (eg_event_t){EG_EVENT_ERROR, EAGAIN};
+    return eg_input_read(me->in, -1);
+  }
+
+  while (true) {
+    const uint64_t now = now_ms();
+
+    // if this device is ticking and ≥ a tick has passed, yield that
+    const bool ticking = me->tick > 0 && !me->idle;
+    if (ticking && now - me->last_tick >= (uint64_t)me->tick) {
       me->last_tick = now;
       return (eg_event_t){.type = EG_EVENT_TICK};
     }
 
-    // if < a tick has passed, we want to account for this slice
-    tick = me->tick - (int)(now - me->last_tick);
+    // if a timer has expired, yield that
+    timers_advance(&me->timers, now);
+    uint32_t tag;
+    if (timers_pop(&me->timers, &tag))
+      return (eg_event_t){EG_EVENT_TIMER, tag};
+
+    const int timeout = block ? time_left(me, now) : 0;
+    const eg_event_t event = eg_input_read(me->in, timeout);
+    if (block)
+      ++me->stats.wakeups;
+
+    // if the wait ran out, go around again to see which deadline passed
+    if (event.type != EG_EVENT_TICK)
+      return event;
+
+    if (!block)
+      return (eg_event_t){EG_EVENT_ERROR, EAGAIN};
   }
+}
+
+/// common implementation of `eg_io_read` and `eg_io_poll`
+static eg_event_t read_event(eg_io_t *me, bool block) {
+  assert(me != NULL);
+
+  const eg_event_t event = next_event(me, block);
+
+  // nothing happened, so there is nothing to count or record
+  if (event.type == EG_EVENT_ERROR && event.value == EAGAIN && !block)
+    return event;
 
-  const eg_event_t event = eg_input_read(me->in, tick);
+  if (event.type == EG_EVENT_TICK)
+    ++me->stats.ticks;
+  if (event.type == EG_EVENT_TIMER)
+    ++me->stats.timers;
 
-  // if we ticked, note this for next time
-  if (event.type == EG_EVENT_TICK) {
-    const int err = get_time(&me->last_tick);
+  // the user is back, so resume ticking
+  if (event.type == EG_EVENT_KEYPRESS)
+    me->idle = false;
+
+  if (me->record != NULL) {
+    const uint64_t now = now_ms();
+    const int err = record_write(me->record, now - me->last_record, event);
     if (err != 0)
-      return (eg_event_t){EG_EVENT_ERROR, err};
+      return (eg_event_t){EG_EVENT_ERROR, (uint32_t)err};
+    me->last_record = now;
   }
 
   return event;
 }
 
+eg_event_t eg_io_read(eg_io_t *me) {
+
+  if (me == NULL)
+    return (eg_event_t){EG_EVENT_ERROR, EINVAL};
+
+  return read_event(me, true);
+}
+
+eg_event_t eg_io_poll(eg_io_t *me) {
+
+  if (me == NULL)
+    return (eg_event_t){EG_EVENT_ERROR, EINVAL};
+
+  return read_event(me, false);
+}
+
+int eg_io_get_fds(const eg_io_t *me, int *fds, size_t capacity, size_t *n) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (fds == NULL && capacity > 0)
+    return EINVAL;
+
+  if (n == NULL)
+    return EINVAL;
+
+  // a replay needs nothing from outside
+  *n = 0;
+  if (me->in->replay != NULL)
+    return 0;
+
+  const int fd = fileno(me->in->in);
+  if (fd < 0)
+    return errno;
+  if (capacity > 0)
+    fds[0] = fd;
+  *n = 1;
+
+  return 0;
+}
+
+int eg_io_get_timeout(eg_io_t *me, int *timeout) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (timeout == NULL)
+    return EINVAL;
+
+  // a replay’s next event is due after its recorded delay
+  if (me->in->replay != NULL) {
+    const uint64_t left = input_replay_left(me->in, now_ms());
+    *timeout = left > INT_MAX ? INT_MAX : (int)left;
+    return 0;
+  }
+
+  // keys pressed while probing are already waiting
+  if (input_pending(me->in)) {
+    *timeout = 0;
+    return 0;
+  }
+
+  *timeout = time_left(me, now_ms());
+
+  return 0;
+}
+
 size_t eg_io_get_columns(const eg_io_t *me) {
   assert(me != NULL);
   return eg_output_get_columns(me->out);
@@ -151,6 +374,28 @@ size_t eg_io_get_rows(const eg_io_t *me) {
   return eg_output_get_rows(me->out);
 }
 
+int eg_io_probe(eg_io_t *me, int timeout) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  const int replies = me->in->replay == NULL ? fileno(me->in->in) : -1;
+
+  int rc = 0;
+  if ((rc = output_probe(me->out, replies, timeout)))
+    return rc;
+
+  return take_stray(me->in, me->out);
+}
+
+int eg_io_get_capabilities(const eg_io_t *me, eg_capabilities_t *caps) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return eg_output_get_capabilities(me->out, caps);
+}
+
 int eg_io_put(eg_io_t *me, size_t x, size_t y, const char *text, size_t len) {
 
   if (me == NULL)
@@ -159,6 +404,15 @@ int eg_io_put(eg_io_t *me, size_t x, size_t y, const char *text, size_t len) {
   return eg_output_put(me->out, x, y, text, len);
 }
 
+int io_put_encoded(eg_io_t *me, size_t x, size_t y, encoded_t *cells,
+                   size_t n) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return output_put_encoded(me->out, x, y, cells, n);
+}
+
 int eg_io_puts(eg_io_t *me, size_t x, size_t y, const char *text) {
 
   if (me == NULL)
@@ -172,23 +426,19 @@ int eg_io_print(eg_io_t *me, size_t x, size_t y, const char *format, ...) {
   if (me == NULL)
     return EINVAL;
 
-  char *buffer = NULL;
   va_list ap;
   int rc = 0;
 
   va_start(ap, format);
 
-  if (vasprintf(&buffer, format, ap) < 0) {
-    buffer = NULL;
-    rc = ENOMEM;
+  buffer_reset(&me->scratch);
+  if ((rc = buffer_vprintf(&me->scratch, format, ap)))
     goto done;
-  }
 
-  if ((rc = eg_io_puts(me, x, y, buffer)))
+  if ((rc = eg_io_put(me, x, y, me->scratch.data, me->scratch.len)))
     goto done;
 
 done:
-  free(buffer);
   va_end(ap);
 
   return rc;
@@ -202,6 +452,67 @@ int eg_io_sync(eg_io_t *me) {
   return eg_output_sync(me->out);
 }
 
+bool eg_io_should_render(eg_io_t *me) {
+
+  if (me == NULL)
+    return false;
+
+  return eg_output_should_render(me->out);
+}
+
+int eg_io_set_frame_skip(eg_io_t *me, bool skip) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return eg_output_set_frame_skip(me->out, skip);
+}
+
+int eg_io_get_stats(eg_io_t *me, eg_io_stats_t *stats) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (stats == NULL)
+    return EINVAL;
+
+  *stats = me->stats;
+
+  return 0;
+}
+
+int eg_io_get_output_stats(eg_io_t *me, eg_output_stats_t *stats) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return eg_output_get_stats(me->out, stats);
+}
+
+int eg_io_capture(eg_io_t *me, FILE *file, eg_capture_format_t format) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return eg_output_capture(me->out, file, format);
+}
+
+int eg_io_set_synchronized(eg_io_t *me, bool synchronized) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return eg_output_set_synchronized(me->out, synchronized);
+}
+
+int eg_io_set_async(eg_io_t *me, bool async) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return eg_output_set_async(me->out, async);
+}
+
 int eg_io_clear(eg_io_t *me) {
 
   if (me == NULL)
@@ -260,6 +571,8 @@ void eg_io_free(eg_io_t **me) {
   eg_output_free(&(*me)->out);
   eg_input_free(&(*me)->in);
 
+  timers_free(&(*me)->timers);
+  buffer_free(&(*me)->scratch);
   free(*me);
   *me = NULL;
 }
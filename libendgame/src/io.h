@@ -1,9 +1,14 @@
 #pragma once
 
+#include "buffer.h"
+#include "frame.h"
+#include "timer.h"
 #include <endgame/input.h>
 #include <endgame/io.h>
 #include <endgame/output.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 struct eg_io {
   eg_input_t *in;
@@ -11,4 +16,29 @@ struct eg_io {
 
   int tick;           ///< current tick, ≤0 for tickless
   uint64_t last_tick; ///< time we last saw a tick event
+  bool idle;          ///< is the tick suspended until the next key press?
+
+  timers_t timers; ///< timers scheduled by the caller
+
+  eg_io_stats_t stats; ///< counts of events read
+
+  FILE *record;         ///< log to record events to, if any
+  uint64_t last_record; ///< time we last recorded an event
+
+  /// buffer `eg_io_print` formats into
+  ///
+  /// This is kept between calls and only grows, so printing into a HUD every
+  /// tick does not allocate once it has reached its longest message.
+  buffer_t scratch;
 };
+
+/// write prepared cells to the back buffer
+///
+/// \param me I/O device to write to
+/// \param x Column at which to begin the write, 1-based
+/// \param y Row at which to begin the write, 1-based
+/// \param cells Cells to write
+/// \param n Number of entries in `cells`
+/// \return 0 on success or an errno on failure
+int io_put_encoded(eg_io_t *me, size_t x, size_t y, encoded_t *cells,
+                   size_t n);
@@ -0,0 +1,166 @@
+#include "label.h"
+#include "buffer.h"
+#include "split.h"
+#include <assert.h>
+#include <endgame/io.h>
+#include <endgame/label.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+int eg_label_new(eg_label_t **me, eg_io_t *io, size_t x, size_t y) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (io == NULL)
+    return EINVAL;
+
+  *me = NULL;
+
+  eg_label_t *const l = calloc(1, sizeof(*l));
+  if (l == NULL)
+    return ENOMEM;
+
+  l->io = io;
+  l->x = x;
+  l->y = y;
+
+  *me = l;
+
+  return 0;
+}
+
+/// columns occupied by some text
+static size_t measure(const char *text, size_t len) {
+  assert(text != NULL || len == 0);
+
+  split_t split;
+  split_init(&split, text, len);
+
+  size_t width = 0;
+  const char *cluster;
+  size_t cluster_len, cluster_width;
+  while (split_next(&split, &cluster, &cluster_len, &cluster_width))
+    width += cluster_width;
+
+  return width;
+}
+
+/// display the text in a label’s scratch buffer, if it has changed
+///
+/// \param me Label to update
+/// \return 0 on success or an errno on failure
+static int update(eg_label_t *me) {
+  assert(me != NULL);
+
+  const size_t len = me->scratch.len;
+  if (me->valid && len == me->text.len &&
+      (len == 0 || memcmp(me->scratch.data, me->text.data, len) == 0))
+    return 0;
+
+  int rc = 0;
+
+  // pad with spaces to cover whatever the previous text occupied beyond this
+  // text, whether or not that is still displayed
+  const size_t width = measure(me->scratch.data, len);
+  const size_t pad = me->width > width ? me->width - width : 0;
+  if ((rc = buffer_append_fill(&me->scratch, ' ', pad)))
+    return rc;
+
+  // remember this text before displaying it, so we do not end up with an
+  // inaccurate record of what is displayed
+  me->valid = false;
+  buffer_reset(&me->text);
+  if ((rc = buffer_append(&me->text, me->scratch.data, len)))
+    return rc;
+
+  // write the padding separately, so it does not pick up any styling left
+  // active at the end of the text
+  if ((rc = eg_io_put(me->io, me->x, me->y, me->scratch.data, len)))
+    return rc;
+  if (pad > 0 && (rc = eg_io_put(me->io, me->x + width, me->y,
+                                 &me->scratch.data[len], pad)))
+    return rc;
+
+  me->width = width;
+  me->valid = true;
+
+  return 0;
+}
+
+int eg_label_set(eg_label_t *me, const char *text) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (text == NULL)
+    return EINVAL;
+
+  const size_t len = strlen(text);
+
+  // fast path for unchanged text, saving a copy into the scratch buffer
+  if (me->valid && len == me->text.len &&
+      (len == 0 || memcmp(text, me->text.data, len) == 0))
+    return 0;
+
+  buffer_reset(&me->scratch);
+  int rc = 0;
+  if ((rc = buffer_append(&me->scratch, text, len)))
+    return rc;
+
+  return update(me);
+}
+
+int eg_label_print(eg_label_t *me, const char *format, ...) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (format == NULL)
+    return EINVAL;
+
+  va_list ap;
+  int rc = 0;
+
+  va_start(ap, format);
+
+  buffer_reset(&me->scratch);
+  if ((rc = buffer_vprintf(&me->scratch, format, ap)))
+    goto done;
+
+  rc = update(me);
+
+done:
+  va_end(ap);
+
+  return rc;
+}
+
+int eg_label_invalidate(eg_label_t *me) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  me->valid = false;
+
+  return 0;
+}
+
+void eg_label_free(eg_label_t **me) {
+
+  if (me == NULL)
+    return;
+
+  if (*me == NULL)
+    return;
+
+  buffer_free(&(*me)->scratch);
+  buffer_free(&(*me)->text);
+
+  free(*me);
+  *me = NULL;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "buffer.h"
+#include <endgame/io.h>
+#include <endgame/label.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct eg_label {
+  eg_io_t *io; ///< device being drawn onto
+  size_t x;    ///< column of `io` at which the label begins, 1-based
+  size_t y;    ///< row of `io` on which the label sits, 1-based
+
+  buffer_t text; ///< text last displayed
+  size_t width;  ///< columns `text` occupied
+
+  /// space for formatting new text and padding it to cover the old
+  buffer_t scratch;
+
+  bool valid; ///< does `text` reflect what is displayed?
+};
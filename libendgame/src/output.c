@@ -1,10 +1,22 @@
 #include "output.h"
+#include "buffer.h"
+#include "capture.h"
+#include "clock.h"
+#include "frame.h"
+#include "glyph.h"
+#include "panel.h"
+#include "probe.h"
 #include <assert.h>
 #include <endgame/output.h>
+#include <endgame/panel.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +37,331 @@ static int set_window_size(eg_output_t *out) {
   return 0;
 }
 
+/// write bytes directly to the terminal
+static int emit(eg_output_t *me, const char *data, size_t len) {
+  assert(me != NULL);
+  assert(data != NULL || len == 0);
+
+  int rc = 0;
+  if ((rc = capture_write(&me->capture, data, len)))
+    return rc;
+
+  // a headless output discards everything
+  if (me->out == NULL)
+    return 0;
+
+  if (fwrite(data, 1, len, me->out) < len)
+    return EIO;
+
+  return 0;
+}
+
+/// flush buffered output through to the terminal
+static int flush(eg_output_t *me) {
+  assert(me != NULL);
+
+  if (me->out == NULL)
+    return 0;
+
+  if (fflush(me->out) < 0)
+    return errno;
+
+  return 0;
+}
+
+/// write the changes needed to bring the terminal up to date with a frame
+///
+/// This is the only place frame output is written, and may be called from the
+/// writer thread. Measurements are returned rather than recorded, so the
+/// caller can update statistics under the appropriate lock.
+///
+/// \param me Output to write to
+/// \param next Frame to display
+/// \param bytes [out] Number of bytes written
+/// \param ns [out] Time spent writing
+/// \return 0 on success or an errno on failure
+static int present(eg_output_t *me, const frame_t *next, size_t *bytes,
+                   uint64_t *ns) {
+  assert(me != NULL);
+  assert(next != NULL);
+  assert(bytes != NULL);
+  assert(ns != NULL);
+
+  *bytes = 0;
+  *ns = 0;
+
+  buffer_reset(&me->diff);
+
+  // ask the terminal to hold off rendering until the frame is complete
+  static const char BEGIN[] = "\033[?2026h";
+  static const char END[] = "\033[?2026l";
+  int rc = 0;
+  if (me->synchronized) {
+    if ((rc = buffer_append(&me->diff, BEGIN, sizeof(BEGIN) - 1)))
+      return rc;
+  }
+  const size_t header = me->diff.len;
+
+  if ((rc = frame_scroll(&me->diff, &me->front, next)))
+    return rc;
+
+  if ((rc = frame_diff(&me->diff, &me->front, next, me->caps.rep,
+                       me->caps.ech)))
+    return rc;
+
+  // avoid an empty update if nothing changed
+  if (me->diff.len == header) {
+    buffer_reset(&me->diff);
+  } else if (me->synchronized) {
+    if ((rc = buffer_append(&me->diff, END, sizeof(END) - 1)))
+      return rc;
+  }
+
+  const uint64_t start = now_ns();
+
+  // send the entire update in a single write
+  if ((rc = emit(me, me->diff.data, me->diff.len)))
+    return rc;
+
+  if ((rc = capture_frame(&me->capture)))
+    return rc;
+
+  if ((rc = flush(me)))
+    return rc;
+
+  *bytes = me->diff.len;
+  *ns = now_ns() - start;
+
+  return 0;
+}
+
+/// note the writing of a frame in our statistics
+static void record(eg_output_t *me, size_t bytes, uint64_t ns) {
+  assert(me != NULL);
+
+  ++me->stats.frames;
+  me->stats.bytes += bytes;
+  me->stats.flush_ns = ns;
+  me->last_bytes = bytes;
+  me->last_done = now_ns();
+}
+
+/// how many bytes are waiting in the terminal’s output queue?
+static size_t queued(const eg_output_t *me) {
+  assert(me != NULL);
+
+  int n = 0;
+  if (ioctl(fileno(me->out), TIOCOUTQ, &n) < 0 || n < 0)
+    return 0;
+  return (size_t)n;
+}
+
+/// can we write to the terminal without blocking?
+static bool writable(const eg_output_t *me) {
+  assert(me != NULL);
+
+  struct pollfd pfd = {.fd = fileno(me->out), .events = POLLOUT};
+  if (poll(&pfd, 1, 0) < 0)
+    return true;
+  return (pfd.revents & POLLOUT) != 0;
+}
+
+/// amount of queued output considered “keeping up”, regardless of frame size
+enum { MIN_BACKLOG = 4096 };
+
+/// time to write a frame beyond which the terminal is considered congested
+enum { SLOW_FLUSH_NS = 1000000 };
+
+/// is the terminal behind on output?
+///
+/// If the writer thread is enabled, this must be called with its lock held.
+static bool behind(const eg_output_t *me) {
+  assert(me != NULL);
+
+  if (me->async.enabled) {
+    // a frame waiting on the writer thread will be superseded by the next one
+    if (me->async.has_pending)
+      return true;
+
+    // the writer may be blocked on a full terminal, but we are not
+    if (me->async.busy)
+      return false;
+  }
+
+  // a headless output is never behind
+  if (me->out == NULL)
+    return false;
+
+  // Pseudo-terminals (including SSH sessions) report an empty output queue,
+  // but refuse writes when their peer is not reading.
+  if (!writable(me))
+    return true;
+
+  // If writing the last frame blocked for a while, the terminal is unlikely to
+  // have room for another until it has had as long again to drain.
+  if (me->stats.flush_ns > SLOW_FLUSH_NS &&
+      now_ns() - me->last_done < me->stats.flush_ns)
+    return true;
+
+  // if the terminal has not yet consumed the previous frame, it is not ready
+  // for another
+  const size_t threshold =
+      me->last_bytes > MIN_BACKLOG ? me->last_bytes : MIN_BACKLOG;
+  return queued(me) > threshold;
+}
+
+/// entry point for the writer thread
+static void *writer(void *arg) {
+  eg_output_t *const me = arg;
+  assert(me != NULL);
+
+  (void)pthread_mutex_lock(&me->async.lock);
+
+  while (true) {
+
+    while (!me->async.has_pending && !me->async.stop)
+      (void)pthread_cond_wait(&me->async.wake, &me->async.lock);
+
+    if (!me->async.has_pending)
+      break;
+
+    // take the pending frame, leaving its storage for the next one
+    const frame_t work = me->async.work;
+    me->async.work = me->async.pending;
+    me->async.pending = work;
+    me->async.has_pending = false;
+    me->async.busy = true;
+
+    (void)pthread_mutex_unlock(&me->async.lock);
+
+    size_t bytes;
+    uint64_t ns;
+    const int rc = present(me, &me->async.work, &bytes, &ns);
+
+    // what we just sent becomes the basis for the next diff
+    const frame_t front = me->front;
+    me->front = me->async.work;
+    me->async.work = front;
+
+    (void)pthread_mutex_lock(&me->async.lock);
+
+    if (rc == 0)
+      record(me, bytes, ns);
+    if (me->async.error == 0)
+      me->async.error = rc;
+    me->async.busy = false;
+    (void)pthread_cond_broadcast(&me->async.idle);
+  }
+
+  (void)pthread_mutex_unlock(&me->async.lock);
+
+  return NULL;
+}
+
+/// wait for the writer thread to finish any frames in flight
+static void quiesce(eg_output_t *me) {
+  assert(me != NULL);
+
+  if (!me->async.enabled)
+    return;
+
+  (void)pthread_mutex_lock(&me->async.lock);
+  while (me->async.has_pending || me->async.busy)
+    (void)pthread_cond_wait(&me->async.idle, &me->async.lock);
+  (void)pthread_mutex_unlock(&me->async.lock);
+}
+
+/// stop the writer thread, returning any unreported error
+static int stop_writer(eg_output_t *me) {
+  assert(me != NULL);
+  assert(me->async.enabled);
+
+  (void)pthread_mutex_lock(&me->async.lock);
+  me->async.stop = true;
+  (void)pthread_cond_signal(&me->async.wake);
+  (void)pthread_mutex_unlock(&me->async.lock);
+
+  (void)pthread_join(me->async.thread, NULL);
+
+  const int rc = me->async.error;
+
+  (void)pthread_cond_destroy(&me->async.idle);
+  (void)pthread_cond_destroy(&me->async.wake);
+  (void)pthread_mutex_destroy(&me->async.lock);
+  frame_free(&me->async.work);
+  frame_free(&me->async.pending);
+  me->async.has_pending = false;
+  me->async.stop = false;
+  me->async.error = 0;
+  me->async.enabled = false;
+
+  return rc;
+}
+
+/// how long `eg_output_new` waits for the terminal to answer queries, unless
+/// overridden by `$ENDGAME_PROBE_TIMEOUT`
+enum { PROBE_TIMEOUT_MS = 100 };
+
+/// how long `eg_output_new` should wait for the terminal to answer queries
+static int probe_timeout(void) {
+  const char *const env = getenv("ENDGAME_PROBE_TIMEOUT");
+  if (env == NULL || *env == '\0')
+    return PROBE_TIMEOUT_MS;
+
+  char *end;
+  errno = 0;
+  const long timeout = strtol(env, &end, 10);
+  if (errno != 0 || *end != '\0' || timeout < 0 || timeout > INT_MAX)
+    return PROBE_TIMEOUT_MS;
+
+  return (int)timeout;
+}
+
+/// probe the terminal, resetting it to a known (blank) state afterwards
+///
+/// \param me Output to probe
+/// \param replies File descriptor the terminal’s replies arrive on, or -1 to
+///   read them from the controlling terminal
+/// \param timeout Milliseconds to wait for replies
+/// \return 0 on success or an errno on failure
+static int probe(eg_output_t *me, int replies, int timeout) {
+  assert(me != NULL);
+  assert(me->out != NULL);
+
+  int fd = replies;
+  int rc = 0;
+
+  // without an input to read from, the replies come in on the terminal itself
+  if (replies < 0)
+    fd = open("/dev/tty", O_RDONLY | O_NOCTTY | O_CLOEXEC);
+
+  if ((rc = emit(me, probe_query, strlen(probe_query))))
+    goto done;
+  if ((rc = flush(me)))
+    goto done;
+
+  bool complete;
+  if ((rc = probe_read(fd, timeout, &me->caps, &me->stray, &complete)))
+    goto done;
+  me->unanswered = !complete;
+
+  // the probe may have printed characters, so start over
+  if ((rc = emit(me, "\033[2J", 4)))
+    goto done;
+  frame_clear(&me->front);
+
+  // respect a choice to disable synchronized output, but do not keep using it
+  // if the terminal no longer supports it
+  if (!me->caps.synchronized)
+    me->synchronized = false;
+
+done:
+  if (replies < 0 && fd >= 0)
+    (void)close(fd);
+
+  return rc;
+}
+
 int eg_output_new(eg_output_t **me, FILE *out) {
 
   if (me == NULL)
@@ -33,6 +370,13 @@ int eg_output_new(eg_output_t **me, FILE *out) {
   if (out == NULL)
     return EINVAL;
 
+  return output_new(me, out, -1);
+}
+
+int output_new(eg_output_t **me, FILE *out, int replies) {
+  assert(me != NULL);
+  assert(out != NULL);
+
   *me = NULL;
   eg_output_t *o = NULL;
   int rc = 0;
@@ -62,6 +406,15 @@ int eg_output_new(eg_output_t **me, FILE *out) {
   if ((rc = set_window_size(o)))
     goto done;
 
+  if ((rc = glyphs_new(&o->glyphs)))
+    goto done;
+
+  if ((rc = frame_new(&o->front, &o->glyphs, o->rows, o->columns)))
+    goto done;
+
+  if ((rc = frame_new(&o->back, &o->glyphs, o->rows, o->columns)))
+    goto done;
+
   // read terminal characteristics
   if (tcgetattr(fd, &o->original_termios) < 0) {
     rc = errno;
@@ -85,20 +438,21 @@ int eg_output_new(eg_output_t **me, FILE *out) {
   o->active = true;
 
   // switch to the alternate screen
-  if (fprintf(out, "\033[?1049h") < 0) {
-    rc = EIO;
+  if ((rc = emit(o, "\033[?1049h", 8)))
     goto done;
-  }
 
   // hide the cursor
-  if (fprintf(out, "\033[?25l") < 0) {
-    rc = EIO;
+  if ((rc = emit(o, "\033[?25l", 6)))
     goto done;
-  }
 
-  if ((rc = eg_output_clear(o)))
+  // determine what the terminal supports, leaving the screen clear to match
+  // our (blank) front frame
+  if ((rc = probe(o, replies, probe_timeout())))
     goto done;
 
+  // use synchronized output by default where it is supported
+  o->synchronized = o->caps.synchronized;
+
   // ensure our changes take effect
   if (fflush(out) < 0) {
     rc = errno;
@@ -114,6 +468,42 @@ done:
   return rc;
 }
 
+int eg_output_new_headless(eg_output_t **me, size_t columns, size_t rows) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  *me = NULL;
+  eg_output_t *o = NULL;
+  int rc = 0;
+
+  o = calloc(1, sizeof(*o));
+  if (o == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  o->columns = columns;
+  o->rows = rows;
+
+  if ((rc = glyphs_new(&o->glyphs)))
+    goto done;
+
+  if ((rc = frame_new(&o->front, &o->glyphs, o->rows, o->columns)))
+    goto done;
+
+  if ((rc = frame_new(&o->back, &o->glyphs, o->rows, o->columns)))
+    goto done;
+
+  *me = o;
+  o = NULL;
+
+done:
+  eg_output_free(&o);
+
+  return rc;
+}
+
 size_t eg_output_get_columns(const eg_output_t *me) {
   assert(me != NULL);
   return me->columns;
@@ -124,27 +514,167 @@ size_t eg_output_get_rows(const eg_output_t *me) {
   return me->rows;
 }
 
+int eg_output_probe(eg_output_t *me, int timeout) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  return output_probe(me, -1, timeout);
+}
+
+int output_probe(eg_output_t *me, int replies, int timeout) {
+  assert(me != NULL);
+
+  if (me->debug)
+    return EINVAL;
+
+  // a headless output has nothing to probe
+  if (me->out == NULL)
+    return 0;
+
+  // the writer thread must not write while we are probing
+  quiesce(me);
+
+  return probe(me, replies, timeout);
+}
+
+int eg_output_get_capabilities(const eg_output_t *me, eg_capabilities_t *caps) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (caps == NULL)
+    return EINVAL;
+
+  *caps = me->caps;
+
+  return 0;
+}
+
 int eg_output_put(eg_output_t *me, size_t x, size_t y, const char *text,
                   size_t len) {
   if (me == NULL)
     return EINVAL;
   if (me->debug)
     return EINVAL;
-  if (len > INT_MAX)
+  if (x > me->columns)
+    return ERANGE;
+  if (y > me->rows)
     return ERANGE;
+  if (text == NULL && len > 0)
+    return EINVAL;
+
+  // like the terminal itself, treat row and column 0 as 1
+  const size_t column = x == 0 ? 0 : x - 1;
+  const size_t row = y == 0 ? 0 : y - 1;
+  if (row >= me->back.rows)
+    return 0;
+
+  return frame_put(&me->back, column, row, text, len);
+}
+
+int output_put_encoded(eg_output_t *me, size_t x, size_t y, encoded_t *cells,
+                       size_t n) {
+  if (me == NULL)
+    return EINVAL;
+  if (me->debug)
+    return EINVAL;
   if (x > me->columns)
     return ERANGE;
   if (y > me->rows)
     return ERANGE;
-  if (fprintf(me->out, "\033[%zu;%zuH%.*s", y, x, (int)len, text) < 0)
-    return EIO;
-  return 0;
+  if (cells == NULL && n > 0)
+    return EINVAL;
+
+  // like the terminal itself, treat row and column 0 as 1
+  const size_t column = x == 0 ? 0 : x - 1;
+  const size_t row = y == 0 ? 0 : y - 1;
+  if (row >= me->back.rows)
+    return 0;
+
+  return frame_put_encoded(&me->back, column, row, cells, n);
 }
 
 int eg_output_puts(eg_output_t *me, size_t x, size_t y, const char *text) {
   return eg_output_put(me, x, y, text, strlen(text));
 }
 
+/// discard unused glyphs, if there are many of them
+static int compact(eg_output_t *me) {
+  assert(me != NULL);
+
+  // Only bother once the table is much larger than the glyphs the frames could
+  // hold, so the cost is amortised across many syncs.
+  size_t cells = me->rows * me->columns;
+  for (size_t i = 0; i < me->n_panels; ++i)
+    cells += me->panels[i]->frame.rows * me->panels[i]->frame.columns;
+  if (me->glyphs.n < 65536 || me->glyphs.n < 4 * cells)
+    return 0;
+
+  // The writer thread must not be reading glyphs while we rebuild the table.
+  // Rather than stall this sync waiting for it, leave compaction to a later
+  // sync that finds the writer idle. The writer cannot pick up new work while
+  // we hold its lock.
+  if (me->async.enabled) {
+    (void)pthread_mutex_lock(&me->async.lock);
+    if (me->async.has_pending || me->async.busy) {
+      (void)pthread_mutex_unlock(&me->async.lock);
+      return 0;
+    }
+  }
+
+  int rc = 0;
+
+  const size_t n = 2 + me->n_panels;
+  frame_t **const frames = malloc(n * sizeof(frames[0]));
+  if (frames == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+  frames[0] = &me->front;
+  frames[1] = &me->back;
+  for (size_t i = 0; i < me->n_panels; ++i)
+    frames[2 + i] = &me->panels[i]->frame;
+
+  rc = frame_compact(frames, n);
+
+done:
+  free(frames);
+  if (me->async.enabled)
+    (void)pthread_mutex_unlock(&me->async.lock);
+
+  return rc;
+}
+
+int output_add_panel(eg_output_t *me, eg_panel_t *panel) {
+  assert(me != NULL);
+  assert(panel != NULL);
+
+  eg_panel_t **const ps =
+      realloc(me->panels, (me->n_panels + 1) * sizeof(me->panels[0]));
+  if (ps == NULL)
+    return ENOMEM;
+  me->panels = ps;
+  me->panels[me->n_panels] = panel;
+  ++me->n_panels;
+
+  return 0;
+}
+
+void output_remove_panel(eg_output_t *me, eg_panel_t *panel) {
+  assert(me != NULL);
+  assert(panel != NULL);
+
+  for (size_t i = 0; i < me->n_panels; ++i) {
+    if (me->panels[i] != panel)
+      continue;
+    memmove(&me->panels[i], &me->panels[i + 1],
+            (me->n_panels - i - 1) * sizeof(me->panels[0]));
+    --me->n_panels;
+    return;
+  }
+}
+
 int eg_output_sync(eg_output_t *me) {
 
   if (me == NULL)
@@ -153,12 +683,198 @@ int eg_output_sync(eg_output_t *me) {
   if (me->debug)
     return EINVAL;
 
-  if (fflush(me->out) < 0)
-    return errno;
+  panel_composite(me->panels, me->n_panels, &me->back);
+
+  int rc = 0;
+
+  if (me->async.enabled) {
+    (void)pthread_mutex_lock(&me->async.lock);
+
+    // collect any failure from writing a previous frame
+    rc = me->async.error;
+    me->async.error = 0;
+
+    if (rc == 0 && me->skip && behind(me)) {
+      ++me->stats.skipped;
+      (void)pthread_mutex_unlock(&me->async.lock);
+      return 0;
+    }
+
+    // hand this frame to the writer, superseding any it has not yet started
+    if (rc == 0) {
+      frame_copy(&me->async.pending, &me->back);
+      if (me->async.has_pending)
+        ++me->stats.skipped;
+      me->async.has_pending = true;
+      (void)pthread_cond_signal(&me->async.wake);
+    }
+
+    (void)pthread_mutex_unlock(&me->async.lock);
+
+  } else {
+    if (me->skip && behind(me)) {
+      ++me->stats.skipped;
+      return 0;
+    }
+
+    size_t bytes;
+    uint64_t ns;
+    rc = present(me, &me->back, &bytes, &ns);
+    if (rc == 0) {
+      record(me, bytes, ns);
+      frame_copy(&me->front, &me->back);
+    }
+  }
+
+  if (rc != 0)
+    return rc;
+
+  return compact(me);
+}
+
+bool eg_output_should_render(eg_output_t *me) {
+
+  if (me == NULL)
+    return false;
+
+  if (me->async.enabled)
+    (void)pthread_mutex_lock(&me->async.lock);
+
+  const bool ready = !behind(me);
+
+  if (me->async.enabled)
+    (void)pthread_mutex_unlock(&me->async.lock);
+
+  return ready;
+}
+
+int eg_output_set_frame_skip(eg_output_t *me, bool skip) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  me->skip = skip;
+
+  return 0;
+}
+
+int eg_output_capture(eg_output_t *me, FILE *file,
+                      eg_capture_format_t format) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (format != EG_CAPTURE_RAW && format != EG_CAPTURE_ASCIICAST)
+    return EINVAL;
+
+  // the writer thread uses the capture when writing a frame
+  quiesce(me);
+
+  me->capture.file = NULL;
+
+  if (file == NULL)
+    return 0;
+
+  return capture_start(&me->capture, file, format, me->columns, me->rows);
+}
+
+int eg_output_set_synchronized(eg_output_t *me, bool synchronized) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (synchronized && !me->caps.synchronized)
+    return ENOTSUP;
+
+  // the writer thread reads this setting when writing a frame
+  quiesce(me);
+
+  me->synchronized = synchronized;
 
   return 0;
 }
 
+int eg_output_get_stats(eg_output_t *me, eg_output_stats_t *stats) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (stats == NULL)
+    return EINVAL;
+
+  if (me->async.enabled)
+    (void)pthread_mutex_lock(&me->async.lock);
+
+  *stats = me->stats;
+
+  if (me->async.enabled)
+    (void)pthread_mutex_unlock(&me->async.lock);
+
+  stats->queued = me->out == NULL ? 0 : queued(me);
+
+  return 0;
+}
+
+int eg_output_set_async(eg_output_t *me, bool async) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (async == me->async.enabled)
+    return 0;
+
+  if (!async)
+    return stop_writer(me);
+
+  int rc = 0;
+  bool have_lock = false;
+  bool have_wake = false;
+  bool have_idle = false;
+
+  if ((rc = frame_new(&me->async.pending, &me->glyphs, me->rows,
+                      me->columns)))
+    goto done;
+
+  if ((rc = frame_new(&me->async.work, &me->glyphs, me->rows, me->columns)))
+    goto done;
+
+  if ((rc = pthread_mutex_init(&me->async.lock, NULL)))
+    goto done;
+  have_lock = true;
+
+  if ((rc = pthread_cond_init(&me->async.wake, NULL)))
+    goto done;
+  have_wake = true;
+
+  if ((rc = pthread_cond_init(&me->async.idle, NULL)))
+    goto done;
+  have_idle = true;
+
+  // flush anything written synchronously, so the writer has sole use of the
+  // stream from here on
+  if ((rc = flush(me)))
+    goto done;
+
+  if ((rc = pthread_create(&me->async.thread, NULL, writer, me)))
+    goto done;
+
+  me->async.enabled = true;
+
+done:
+  if (rc != 0) {
+    if (have_idle)
+      (void)pthread_cond_destroy(&me->async.idle);
+    if (have_wake)
+      (void)pthread_cond_destroy(&me->async.wake);
+    if (have_lock)
+      (void)pthread_mutex_destroy(&me->async.lock);
+    frame_free(&me->async.work);
+    frame_free(&me->async.pending);
+  }
+
+  return rc;
+}
+
 int eg_output_clear(eg_output_t *me) {
 
   if (me == NULL)
@@ -167,9 +883,11 @@ int eg_output_clear(eg_output_t *me) {
   if (me->debug)
     return EINVAL;
 
-  // clear screen and move to upper left
-  if (fprintf(me->out, "\033[2J") < 0)
-    return EIO;
+  frame_clear(&me->back);
+
+  // the panels need to be redrawn onto the now blank frame
+  for (size_t i = 0; i < me->n_panels; ++i)
+    (void)eg_panel_invalidate(me->panels[i]);
 
   return 0;
 }
@@ -204,34 +922,48 @@ int eg_output_vdebug(eg_output_t *me, const char *format, va_list ap) {
   if (me == NULL)
     return EINVAL;
 
+  // there is no screen to show a headless output’s debug messages on
+  if (me->out == NULL) {
+    me->debug = true;
+    return 0;
+  }
+
   if (!me->active)
     return EINVAL;
 
+  // the writer must not be mid-frame when we leave the alternate screen
+  quiesce(me);
+
   // drain anything pending to avoid it coming out once we switch away from
   // the alternate screen
   fflush(me->out);
 
   int rc = 0;
+  char *message = NULL;
 
   // switch out of the alternate screen
-  if (fprintf(me->out, "\033[?1049l") < 0) {
-    rc = EIO;
+  if ((rc = emit(me, "\033[?1049l", 8)))
     goto done;
-  }
 
   // set debug here, so we know we are in the normal screen
   me->debug = true;
 
   // print what the user requested
-  if (vfprintf(me->out, format, ap) < 0) {
-    rc = EIO;
+  const int len = vasprintf(&message, format, ap);
+  if (len < 0) {
+    message = NULL;
+    rc = ENOMEM;
     goto done;
   }
+  if ((rc = emit(me, message, (size_t)len)))
+    goto done;
 
   // ensure this is visible to the user
   fflush(me->out);
 
 done:
+  free(message);
+
   return rc;
 }
 
@@ -243,17 +975,29 @@ int eg_output_continue(eg_output_t *me) {
   if (!me->debug)
     return EINVAL;
 
+  if (me->out == NULL) {
+    me->debug = false;
+    return 0;
+  }
+
   int rc = 0;
 
+  // the writer thread must not be using the front frame while we reset it
+  quiesce(me);
+
   // drain anything pending to avoid it coming out once we switch back to
   // the alternate screen
   fflush(me->out);
 
   // switch back to the alternate screen
-  if (fprintf(me->out, "\033[?1049h") < 0) {
-    rc = EIO;
+  if ((rc = emit(me, "\033[?1049h", 8)))
     goto done;
-  }
+
+  // Many terminals clear the alternate screen on entering it, so start over.
+  // The next sync then redraws everything, rather than only what changed.
+  if ((rc = emit(me, "\033[2J", 4)))
+    goto done;
+  frame_clear(&me->front);
 
   me->debug = false;
 
@@ -272,19 +1016,23 @@ void eg_output_free(eg_output_t **me) {
   if (*me == NULL)
     return;
 
+  if ((*me)->async.enabled)
+    (void)stop_writer(*me);
+
   if ((*me)->active) {
 
     // drain anything pending to avoid it coming out once we switch away from
     // the alternate screen
     fflush((*me)->out);
 
-    (void)eg_output_clear(*me);
+    // clear the alternate screen
+    (void)emit(*me, "\033[2J", 4);
 
     // show the cursor
-    fprintf((*me)->out, "\033[?25h");
+    (void)emit(*me, "\033[?25h", 6);
 
     // switch out of the alternate screen
-    fprintf((*me)->out, "\033[?1049l");
+    (void)emit(*me, "\033[?1049l", 8);
 
     // restore the original terminal characteristics
     (void)tcsetattr(fileno((*me)->out), TCSANOW, &(*me)->original_termios);
@@ -292,6 +1040,13 @@ void eg_output_free(eg_output_t **me) {
     fflush((*me)->out);
   }
 
+  free((*me)->panels);
+  buffer_free(&(*me)->stray);
+  buffer_free(&(*me)->diff);
+  frame_free(&(*me)->back);
+  frame_free(&(*me)->front);
+  glyphs_free(&(*me)->glyphs);
+
   free(*me);
   *me = NULL;
 }
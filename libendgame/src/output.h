@@ -1,8 +1,15 @@
 #pragma once
 
+#include "buffer.h"
+#include "capture.h"
+#include "frame.h"
+#include "glyph.h"
 #include <endgame/output.h>
+#include <endgame/panel.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <termios.h>
 
@@ -15,4 +22,99 @@ struct eg_output {
   size_t rows;    ///< terminal height
 
   struct termios original_termios; ///< state of the terminal prior to init
+
+  bool skip; ///< should syncs be skipped while the terminal is behind?
+
+  eg_capabilities_t caps; ///< what the terminal supports
+
+  /// input that arrived while probing but was not a reply
+  ///
+  /// This is handed on to the input device (see `eg_io_new`) so key presses
+  /// during a probe are not lost.
+  buffer_t stray;
+  bool unanswered; ///< might replies to the last probe still arrive?
+  bool synchronized; ///< should frames be bracketed as synchronized updates?
+
+  /// counters and measurements, protected by `async.lock` if enabled
+  eg_output_stats_t stats;
+  size_t last_bytes;  ///< size of the most recently written frame
+  uint64_t last_done; ///< time at which the most recent frame was written
+
+  capture_t capture; ///< copy of output being saved, if any
+
+  glyphs_t glyphs; ///< table interning the content of every frame’s cells
+  frame_t front;   ///< what the terminal is currently displaying
+  frame_t back;    ///< what will be displayed after the next sync
+  buffer_t diff;   ///< scratch space for constructing terminal output
+
+  /// panels composited onto `back` at each sync, bottom-most first
+  eg_panel_t **panels;
+  size_t n_panels;
+
+  /// state for writing frames from a background thread
+  ///
+  /// The writer holds at most one pending frame. If the caller syncs again
+  /// before the writer gets to it, the newer frame replaces it, so the writer
+  /// only ever sends the latest frame relative to what it has already sent.
+  struct {
+    bool enabled;     ///< is the writer thread running?
+    pthread_t thread; ///< the writer thread
+    pthread_mutex_t lock;
+    pthread_cond_t wake; ///< signalled when a frame is pending or on stop
+    pthread_cond_t idle; ///< signalled when the writer finishes a frame
+
+    // fields below are protected by `lock`
+    frame_t pending;  ///< most recently synced frame
+    bool has_pending; ///< is `pending` yet to be written?
+    bool busy;        ///< is the writer currently writing a frame?
+    bool stop;        ///< should the writer exit?
+    int error;        ///< first unreported error from writing
+
+    frame_t work; ///< frame being written, owned by the writer
+  } async;
 };
+
+/// `eg_output_new`, reading the terminal’s replies to probing from `replies`
+///
+/// \param me [out] Created output on success
+/// \param out Stream for this output
+/// \param replies File descriptor the terminal’s replies arrive on, or -1 to
+///   read them from the controlling terminal
+/// \return 0 on success or an errno on failure
+int output_new(eg_output_t **me, FILE *out, int replies);
+
+/// `eg_output_probe`, reading the terminal’s replies from `replies`
+///
+/// \param me Output to probe
+/// \param replies File descriptor the terminal’s replies arrive on, or -1 to
+///   read them from the controlling terminal
+/// \param timeout Milliseconds to wait for replies
+/// \return 0 on success or an errno on failure
+int output_probe(eg_output_t *me, int replies, int timeout);
+
+/// write prepared cells to the back buffer
+///
+/// This is equivalent to `eg_output_put` with the text the cells were prepared
+/// from.
+///
+/// \param me Output to write to
+/// \param x Column at which to begin the write, 1-based
+/// \param y Row at which to begin the write, 1-based
+/// \param cells Cells to write
+/// \param n Number of entries in `cells`
+/// \return 0 on success or an errno on failure
+int output_put_encoded(eg_output_t *me, size_t x, size_t y, encoded_t *cells,
+                       size_t n);
+
+/// start compositing a panel at each sync
+///
+/// \param me Output to composite onto
+/// \param panel Panel to add above any existing ones
+/// \return 0 on success or an errno on failure
+int output_add_panel(eg_output_t *me, eg_panel_t *panel);
+
+/// stop compositing a panel
+///
+/// \param me Output the panel was added to
+/// \param panel Panel to remove
+void output_remove_panel(eg_output_t *me, eg_panel_t *panel);
@@ -0,0 +1,269 @@
+#include "panel.h"
+#include "buffer.h"
+#include "form.h"
+#include "frame.h"
+#include "io.h"
+#include "output.h"
+#include "raster.h"
+#include "scene.h"
+#include <assert.h>
+#include <endgame/io.h>
+#include <endgame/panel.h>
+#include <endgame/scene.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int eg_panel_new(eg_panel_t **me, eg_io_t *io, size_t x, size_t y,
+                 size_t columns, size_t rows) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (io == NULL)
+    return EINVAL;
+
+  if (columns > 0 && rows > SIZE_MAX / columns / sizeof(cell_t))
+    return EOVERFLOW;
+
+  *me = NULL;
+  eg_panel_t *p = NULL;
+  int rc = 0;
+
+  p = calloc(1, sizeof(*p));
+  if (p == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  // like the terminal itself, treat row and column 0 as 1
+  p->x = x == 0 ? 0 : x - 1;
+  p->y = y == 0 ? 0 : y - 1;
+
+  if ((rc = frame_new(&p->frame, &io->out->glyphs, rows, columns)))
+    goto done;
+
+  // allocate at least one element so a degenerate panel is not mistaken for an
+  // allocation failure
+  p->shown = calloc(rows + 1, sizeof(p->shown[0]));
+  p->stale = calloc(rows + 1, sizeof(p->stale[0]));
+  if (p->shown == NULL || p->stale == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  // the area beneath the panel is not known to be blank, so display it in full
+  (void)eg_panel_invalidate(p);
+
+  if ((rc = output_add_panel(io->out, p)))
+    goto done;
+  p->out = io->out;
+
+  *me = p;
+  p = NULL;
+
+done:
+  eg_panel_free(&p);
+
+  return rc;
+}
+
+size_t eg_panel_get_columns(const eg_panel_t *me) {
+
+  if (me == NULL)
+    return 0;
+
+  return me->frame.columns;
+}
+
+size_t eg_panel_get_rows(const eg_panel_t *me) {
+
+  if (me == NULL)
+    return 0;
+
+  return me->frame.rows;
+}
+
+int eg_panel_put(eg_panel_t *me, size_t x, size_t y, const char *text,
+                 size_t len) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (text == NULL && len > 0)
+    return EINVAL;
+
+  // like the terminal itself, treat row and column 0 as 1
+  const size_t column = x == 0 ? 0 : x - 1;
+  const size_t row = y == 0 ? 0 : y - 1;
+
+  // clip anything outside the panel
+  if (row >= me->frame.rows)
+    return 0;
+
+  return frame_put(&me->frame, column, row, text, len);
+}
+
+int eg_panel_puts(eg_panel_t *me, size_t x, size_t y, const char *text) {
+
+  if (text == NULL)
+    return EINVAL;
+
+  return eg_panel_put(me, x, y, text, strlen(text));
+}
+
+int eg_panel_print(eg_panel_t *me, size_t x, size_t y, const char *format,
+                   ...) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (format == NULL)
+    return EINVAL;
+
+  va_list ap;
+  int rc = 0;
+
+  va_start(ap, format);
+
+  buffer_reset(&me->scratch);
+  if ((rc = buffer_vprintf(&me->scratch, format, ap)))
+    goto done;
+
+  rc = eg_panel_put(me, x, y, me->scratch.data, me->scratch.len);
+
+done:
+  va_end(ap);
+
+  return rc;
+}
+
+int eg_panel_paint_scene(eg_panel_t *me, eg_scene_t *scene, eg_2D_t origin) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (scene == NULL)
+    return EINVAL;
+
+  eg_scene_sync(scene);
+
+  const size_t rows = me->frame.rows;
+  const size_t columns = me->frame.columns;
+
+  // do we need to expand our compositing space?
+  if (rows * columns > me->c_raster) {
+    cell_t *const r = realloc(me->raster, rows * columns * sizeof(r[0]));
+    if (r == NULL)
+      return ENOMEM;
+    me->raster = r;
+    me->c_raster = rows * columns;
+  }
+
+  scene_compose(scene, me->raster, columns, rows, origin);
+
+  encoded_t blank = {.width = 1};
+
+  for (size_t row = 0; row < rows; ++row) {
+    for (size_t col = 0; col < columns; ++col) {
+      const cell_t c = me->raster[row * columns + col];
+
+      // skip cells displayed by the wide form to their left
+      if (c == COVERED)
+        continue;
+
+      const int rc =
+          c == NULL ? frame_put_encoded(&me->frame, col, row, &blank, 1)
+                    : frame_put_encoded(&me->frame, col, row, c->cells,
+                                        c->n_cells);
+      if (rc != 0)
+        return rc;
+    }
+  }
+
+  return 0;
+}
+
+int eg_panel_clear(eg_panel_t *me) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  frame_clear(&me->frame);
+
+  return 0;
+}
+
+int eg_panel_invalidate(eg_panel_t *me) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  for (size_t i = 0; i < me->frame.rows; ++i)
+    me->stale[i] = true;
+
+  return 0;
+}
+
+void panel_composite(eg_panel_t *const *panels, size_t n, frame_t *dst) {
+  assert(panels != NULL || n == 0);
+  assert(dst != NULL);
+
+  for (size_t i = 0; i < n; ++i) {
+    eg_panel_t *const p = panels[i];
+    assert(p->frame.glyphs == dst->glyphs);
+
+    for (size_t row = 0; row < p->frame.rows; ++row) {
+
+      // skip rows off the bottom of the screen
+      const size_t y = p->y + row;
+      if (y >= dst->rows)
+        break;
+
+      // skip rows that have not changed since they were last displayed
+      if (!p->stale[row] && p->shown[row] == p->frame.hashes[row])
+        continue;
+
+      frame_blit(dst, p->x, y, &p->frame, row);
+      p->shown[row] = p->frame.hashes[row];
+      p->stale[row] = false;
+
+      // any panels overlapping this row now need to be redrawn over it
+      const size_t left = p->x;
+      const size_t right = p->x + p->frame.columns;
+      for (size_t j = i + 1; j < n; ++j) {
+        eg_panel_t *const q = panels[j];
+        if (y < q->y || y - q->y >= q->frame.rows)
+          continue;
+        if (q->x >= right || q->x + q->frame.columns <= left)
+          continue;
+        q->stale[y - q->y] = true;
+      }
+    }
+  }
+}
+
+void eg_panel_free(eg_panel_t **me) {
+
+  if (me == NULL)
+    return;
+
+  if (*me == NULL)
+    return;
+
+  if ((*me)->out != NULL)
+    output_remove_panel((*me)->out, *me);
+
+  buffer_free(&(*me)->scratch);
+  free((*me)->raster);
+  free((*me)->stale);
+  free((*me)->shown);
+  frame_free(&(*me)->frame);
+
+  free(*me);
+  *me = NULL;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "buffer.h"
+#include "frame.h"
+#include "raster.h"
+#include <endgame/output.h>
+#include <endgame/panel.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct eg_panel {
+  eg_output_t *out; ///< device being composited onto
+
+  size_t x; ///< column of `out` at the left edge, 0-based
+  size_t y; ///< row of `out` at the top edge, 0-based
+
+  /// the panel’s content, sharing the glyph table of `out`
+  frame_t frame;
+
+  /// `frame.rows` row hashes as of when each row was last composited
+  uint64_t *shown;
+
+  /// `frame.rows` flags of rows to composite regardless of their hash
+  bool *stale;
+
+  cell_t *raster;  ///< space for compositing scenes
+  size_t c_raster; ///< number of cells allocated in `raster`
+
+  buffer_t scratch; ///< buffer `eg_panel_print` formats into
+};
+
+/// copy changed rows of panels onto a frame
+///
+/// Panels are composited in the order given, later ones over earlier ones.
+///
+/// \param panels Panels to composite
+/// \param n Number of entries in `panels`
+/// \param dst Frame to composite onto, sharing the panels’ glyph table
+void panel_composite(eg_panel_t *const *panels, size_t n, frame_t *dst);
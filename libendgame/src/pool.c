@@ -0,0 +1,173 @@
+#include "pool.h"
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+struct pool {
+  pthread_t *threads;
+  size_t n_threads;
+
+  pthread_mutex_t lock; ///< protects all following fields
+  pthread_cond_t work;  ///< signalled when a new batch begins
+  pthread_cond_t done;  ///< signalled when a batch completes
+
+  void (*fn)(void *ctx, size_t index); ///< task of the current batch
+  void *ctx;                           ///< state of the current batch
+  size_t n;                            ///< number of tasks in the batch
+  size_t next;                         ///< next task to be claimed
+  size_t finished;                     ///< number of completed tasks
+
+  uint64_t generation; ///< count of batches started
+  bool stop;           ///< should workers exit?
+};
+
+/// run tasks from the current batch until none remain unclaimed
+///
+/// This must be called with the pool’s lock held.
+static void drain(pool_t *me) {
+  assert(me != NULL);
+
+  while (me->next < me->n) {
+    const size_t i = me->next++;
+
+    (void)pthread_mutex_unlock(&me->lock);
+    me->fn(me->ctx, i);
+    (void)pthread_mutex_lock(&me->lock);
+
+    if (++me->finished == me->n)
+      (void)pthread_cond_signal(&me->done);
+  }
+}
+
+static void *worker(void *arg) {
+  pool_t *const me = arg;
+  assert(me != NULL);
+
+  (void)pthread_mutex_lock(&me->lock);
+
+  for (uint64_t seen = me->generation;;) {
+    while (!me->stop && me->generation == seen)
+      (void)pthread_cond_wait(&me->work, &me->lock);
+    if (me->stop)
+      break;
+    seen = me->generation;
+    drain(me);
+  }
+
+  (void)pthread_mutex_unlock(&me->lock);
+
+  return NULL;
+}
+
+int pool_new(pool_t **me, size_t threads) {
+  assert(me != NULL);
+
+  *me = NULL;
+  pool_t *p = NULL;
+  int rc = 0;
+
+  p = calloc(1, sizeof(*p));
+  if (p == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  if ((rc = pthread_mutex_init(&p->lock, NULL))) {
+    free(p);
+    p = NULL;
+    goto done;
+  }
+  if ((rc = pthread_cond_init(&p->work, NULL))) {
+    (void)pthread_mutex_destroy(&p->lock);
+    free(p);
+    p = NULL;
+    goto done;
+  }
+  if ((rc = pthread_cond_init(&p->done, NULL))) {
+    (void)pthread_cond_destroy(&p->work);
+    (void)pthread_mutex_destroy(&p->lock);
+    free(p);
+    p = NULL;
+    goto done;
+  }
+
+  // from here on, `pool_free` can clean up a partially constructed pool
+
+  p->threads = calloc(threads, sizeof(p->threads[0]));
+  if (threads > 0 && p->threads == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  for (size_t i = 0; i < threads; ++i) {
+    if ((rc = pthread_create(&p->threads[i], NULL, worker, p)))
+      goto done;
+    ++p->n_threads;
+  }
+
+  *me = p;
+  p = NULL;
+
+done:
+  pool_free(&p);
+
+  return rc;
+}
+
+size_t pool_size(const pool_t *me) {
+  assert(me != NULL);
+  return me->n_threads + 1;
+}
+
+void pool_run(pool_t *me, void (*fn)(void *ctx, size_t index), void *ctx,
+              size_t n) {
+  assert(me != NULL);
+  assert(fn != NULL);
+
+  (void)pthread_mutex_lock(&me->lock);
+
+  me->fn = fn;
+  me->ctx = ctx;
+  me->n = n;
+  me->next = 0;
+  me->finished = 0;
+  ++me->generation;
+  (void)pthread_cond_broadcast(&me->work);
+
+  // participate ourselves, rather than idling while the workers run
+  drain(me);
+
+  while (me->finished < me->n)
+    (void)pthread_cond_wait(&me->done, &me->lock);
+
+  (void)pthread_mutex_unlock(&me->lock);
+}
+
+void pool_free(pool_t **me) {
+
+  if (me == NULL)
+    return;
+
+  if (*me == NULL)
+    return;
+
+  (void)pthread_mutex_lock(&(*me)->lock);
+  (*me)->stop = true;
+  (void)pthread_cond_broadcast(&(*me)->work);
+  (void)pthread_mutex_unlock(&(*me)->lock);
+
+  for (size_t i = 0; i < (*me)->n_threads; ++i)
+    (void)pthread_join((*me)->threads[i], NULL);
+  free((*me)->threads);
+
+  (void)pthread_cond_destroy(&(*me)->done);
+  (void)pthread_cond_destroy(&(*me)->work);
+  (void)pthread_mutex_destroy(&(*me)->lock);
+
+  free(*me);
+  *me = NULL;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+
+/// a fixed set of worker threads for running data-parallel work
+typedef struct pool pool_t;
+
+/// start a pool of worker threads
+///
+/// \param me [out] Created pool on success
+/// \param threads Number of worker threads to start
+/// \return 0 on success or an errno on failure
+int pool_new(pool_t **me, size_t threads);
+
+/// get the number of threads that participate in `pool_run`
+///
+/// This is the number of workers plus one, for the calling thread.
+size_t pool_size(const pool_t *me);
+
+/// run a batch of tasks across the pool
+///
+/// This calls `fn(ctx, i)` for each `i` in [0, `n`), distributing calls across
+/// the workers and the calling thread, and returns once all have completed.
+/// Calls may happen concurrently and in any order.
+///
+/// \param me Pool to run on
+/// \param fn Task to run
+/// \param ctx State to pass to each call of `fn`
+/// \param n Number of calls to make
+void pool_run(pool_t *me, void (*fn)(void *ctx, size_t index), void *ctx,
+              size_t n);
+
+/// stop and destroy a pool of worker threads
+void pool_free(pool_t **me);
@@ -0,0 +1,255 @@
+#include "probe.h"
+#include "buffer.h"
+#include "clock.h"
+#include <assert.h>
+#include <endgame/output.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char probe_query[] = "\033[H"       // move to the top left
+                           "a\033[b"      // print a character and REP it
+                           "\033[6n"      // DSR, request cursor position
+                           "\033[?2026$p" // DECRQM, synchronized output
+                           "\033[?1006$p" // DECRQM, SGR mouse reporting
+                           "\033[>0q"     // XTVERSION
+                           "\033[>c"      // DA2
+                           "\033[c";      // DA1
+
+/// a parsed Control Sequence Introducer reply
+typedef struct {
+  char marker;        ///< private marker (e.g. '?') or 0 for none
+  char intermediate;  ///< intermediate byte (e.g. '$') or 0 for none
+  char final;         ///< final byte
+  unsigned params[4]; ///< numeric parameters, 0 if absent
+  size_t n_params;    ///< number of parameters seen
+} csi_t;
+
+/// parse the body of a CSI sequence, from after “\033[” to its final byte
+static csi_t parse_csi(const char *s, size_t len) {
+  assert(s != NULL);
+  assert(len > 0);
+
+  csi_t c = {.final = s[len - 1]};
+  size_t i = 0;
+  if (s[i] == '?' || s[i] == '>' || s[i] == '=')
+    c.marker = s[i++];
+
+  for (; i + 1 < len; ++i) {
+    if (s[i] >= '0' && s[i] <= '9') {
+      if (c.n_params == 0)
+        c.n_params = 1;
+      if (c.n_params <= sizeof(c.params) / sizeof(c.params[0])) {
+        unsigned *const p = &c.params[c.n_params - 1];
+        *p = *p * 10 + (unsigned)(s[i] - '0');
+      }
+    } else if (s[i] == ';') {
+      ++c.n_params;
+    } else if (s[i] >= 0x20 && s[i] <= 0x2f) {
+      c.intermediate = s[i];
+    }
+  }
+
+  return c;
+}
+
+/// note what a CSI reply tells us
+///
+/// \param c Parsed sequence
+/// \param caps [inout] Capabilities to update
+/// \param done [out] Set if this was the DA1 reply, ending the probe
+/// \return True if this was a reply to one of our queries, rather than e.g. a
+///   key press
+static bool handle_csi(const csi_t *c, eg_capabilities_t *caps, bool *done) {
+  assert(c != NULL);
+  assert(caps != NULL);
+  assert(done != NULL);
+
+  // DECRQM reply: mode and status, where 1–3 mean the mode is recognised
+  if (c->marker == '?' && c->intermediate == '$' && c->final == 'y') {
+    const bool recognised = c->params[1] >= 1 && c->params[1] <= 3;
+    if (c->params[0] == 2026)
+      caps->synchronized = recognised;
+    if (c->params[0] == 1006)
+      caps->sgr_mouse = recognised;
+    return true;
+  }
+
+  // DA2 reply: terminal type and firmware version
+  if (c->marker == '>' && c->final == 'c') {
+    caps->model = c->params[0];
+    caps->firmware = c->params[1];
+    return true;
+  }
+
+  // CPR reply: REP repeated our character if the cursor ended up in column 3
+  if (c->marker == 0 && c->final == 'R') {
+    caps->rep = c->params[1] == 3;
+    return true;
+  }
+
+  // DA1 reply: conformance level, where 62 and above is at least a VT220
+  if (c->marker == '?' && c->final == 'c') {
+    caps->conformance = c->params[0];
+    caps->ech = caps->conformance >= 62;
+    *done = true;
+    return true;
+  }
+
+  return false;
+}
+
+/// note what a DCS reply tells us
+static void handle_dcs(const char *s, size_t len, eg_capabilities_t *caps) {
+  assert(s != NULL);
+  assert(caps != NULL);
+
+  // XTVERSION reply: “>|” followed by the terminal’s name and version
+  if (len >= 2 && s[0] == '>' && s[1] == '|') {
+    size_t n = len - 2;
+    if (n >= sizeof(caps->version))
+      n = sizeof(caps->version) - 1;
+    memcpy(caps->version, &s[2], n);
+    caps->version[n] = '\0';
+  }
+}
+
+int probe_read(int fd, int timeout, eg_capabilities_t *caps, buffer_t *stray,
+               bool *complete) {
+  assert(caps != NULL);
+  assert(stray != NULL);
+  assert(complete != NULL);
+
+  *caps = (eg_capabilities_t){0};
+  *complete = false;
+
+  // there is no query for 24-bit colour, but terminals conventionally
+  // advertise it in the environment
+  const char *const colorterm = getenv("COLORTERM");
+  caps->truecolor = colorterm != NULL && (strcmp(colorterm, "truecolor") == 0 ||
+                                          strcmp(colorterm, "24bit") == 0);
+
+  if (fd < 0)
+    return 0;
+
+  const uint64_t deadline = now_ms() + (uint64_t)(timeout > 0 ? timeout : 0);
+
+  char reply[1024];
+  size_t len = 0;
+  bool done = false;
+  int rc = 0;
+
+  while (!done) {
+
+    const uint64_t t = now_ms();
+    if (t >= deadline)
+      break;
+
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    if (poll(&pfd, 1, (int)(deadline - t)) <= 0)
+      break;
+
+    // if our buffer is full of something other than replies, pass it on
+    if (len == sizeof(reply)) {
+      if ((rc = buffer_append(stray, reply, len)))
+        return rc;
+      len = 0;
+    }
+
+    const ssize_t r = read(fd, &reply[len], sizeof(reply) - len);
+    if (r <= 0)
+      break;
+    len += (size_t)r;
+
+    // consume complete replies from the front of the buffer, setting aside
+    // anything else (e.g. keys pressed while probing) for the input device
+    size_t i = 0;
+    while (i < len && !done) {
+      if (reply[i] != 0x1b) {
+        if ((rc = buffer_append(stray, &reply[i], 1)))
+          return rc;
+        ++i;
+        continue;
+      }
+      if (i + 1 == len)
+        break;
+
+      if (reply[i + 1] == '[') {
+        size_t end = i + 2;
+        while (end < len && !(reply[end] >= 0x40 && reply[end] <= 0x7e))
+          ++end;
+        if (end == len)
+          break;
+        const csi_t c = parse_csi(&reply[i + 2], end - (i + 2) + 1);
+        if (!handle_csi(&c, caps, &done)) {
+          if ((rc = buffer_append(stray, &reply[i], end + 1 - i)))
+            return rc;
+        }
+        i = end + 1;
+
+      } else if (reply[i + 1] == 'P') {
+        size_t end = i + 2;
+        while (end + 1 < len && !(reply[end] == 0x1b && reply[end + 1] == '\\'))
+          ++end;
+        if (end + 1 >= len)
+          break;
+        handle_dcs(&reply[i + 2], end - (i + 2), caps);
+        i = end + 2;
+
+      } else {
+        if ((rc = buffer_append(stray, &reply[i], 2)))
+          return rc;
+        i += 2;
+      }
+    }
+
+    memmove(reply, &reply[i], len - i);
+    len -= i;
+  }
+
+  // anything left over was not a reply
+  if (len > 0) {
+    if ((rc = buffer_append(stray, reply, len)))
+      return rc;
+  }
+
+  *complete = done;
+
+  return 0;
+}
+
+size_t probe_reply(const char *s, size_t len, bool *last) {
+  assert(s != NULL || len == 0);
+  assert(last != NULL);
+
+  *last = false;
+
+  if (len < 3 || s[0] != 0x1b)
+    return 0;
+
+  if (s[1] == '[') {
+    size_t end = 2;
+    while (end < len && !(s[end] >= 0x40 && s[end] <= 0x7e))
+      ++end;
+    if (end == len)
+      return 0;
+    const csi_t c = parse_csi(&s[2], end - 1);
+    eg_capabilities_t ignored = {0};
+    return handle_csi(&c, &ignored, last) ? end + 1 : 0;
+  }
+
+  // XTVERSION is the only DCS reply
+  if (s[1] == 'P' && len >= 4 && s[2] == '>' && s[3] == '|') {
+    for (size_t end = 4; end + 1 < len; ++end) {
+      if (s[end] == 0x1b && s[end + 1] == '\\')
+        return end + 2;
+    }
+  }
+
+  return 0;
+}
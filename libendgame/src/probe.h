@@ -0,0 +1,39 @@
+#pragma once
+
+#include "buffer.h"
+#include <endgame/output.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/// queries to send to the terminal to determine its capabilities
+///
+/// These end with a DA1 query. Every terminal answers this, so its reply marks
+/// the end of the answers to the preceding queries. The query for REP prints
+/// characters at the current cursor position, so the caller should clear the
+/// screen afterwards.
+extern const char probe_query[];
+
+/// read the terminal’s replies to `probe_query`
+///
+/// The terminal’s replies arrive on its input, interleaved with anything else
+/// that happens to be there, e.g. keys pressed while probing. Bytes that are
+/// not replies are set aside, so they can be returned later by the input
+/// device.
+///
+/// \param fd File descriptor to read replies from, or -1 to not wait for any
+/// \param timeout Milliseconds to wait for the terminal to finish replying
+/// \param caps [out] Capabilities of the terminal
+/// \param stray [inout] Buffer to append bytes that were not replies to
+/// \param complete [out] Whether the terminal finished replying, as opposed to
+///   the timeout expiring
+/// \return 0 on success or an errno on failure
+int probe_read(int fd, int timeout, eg_capabilities_t *caps, buffer_t *stray,
+               bool *complete);
+
+/// recognise a reply to `probe_query` that arrived after `probe_read` gave up
+///
+/// \param s Input received from the terminal
+/// \param len Number of bytes in `s`
+/// \param last [out] Set if this was the reply to the final query
+/// \return Length of the reply at the start of `s`, or 0 if there is none
+size_t probe_reply(const char *s, size_t len, bool *last);
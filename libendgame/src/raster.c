@@ -0,0 +1,61 @@
+#include "raster.h"
+#include "sprite.h"
+#include <assert.h>
+#include <stddef.h>
+
+const form_t raster_covered;
+
+/// erase whatever form occupies a given cell
+static void erase(cell_t *row, size_t columns, size_t column) {
+  assert(row != NULL);
+  assert(column < columns);
+
+  // find the start of the form covering this cell
+  size_t start = column;
+  while (start > 0 && row[start] == COVERED)
+    --start;
+
+  // erase it and everything it covers
+  row[start] = NULL;
+  for (size_t i = start + 1; i < columns && row[i] == COVERED; ++i)
+    row[i] = NULL;
+}
+
+size_t raster_put(cell_t *row, size_t columns, size_t column,
+                  const form_t *form) {
+  assert(row != NULL);
+  assert(column < columns);
+  assert(form != NULL);
+  assert(form != COVERED);
+
+  const size_t width = form->width > 1 ? form->width : 1;
+
+  // a form wider than the remaining space cannot be partially drawn
+  if (width > columns - column)
+    return 0;
+
+  // if we are overwriting either end of a wide form, it is no longer visible
+  erase(row, columns, column);
+  erase(row, columns, column + width - 1);
+
+  row[column] = form;
+  for (size_t i = 1; i < width; ++i)
+    row[column + i] = COVERED;
+
+  return width;
+}
+
+void raster_composite(cell_t *dst, size_t columns, size_t column,
+                      const cell_t *src, size_t n) {
+  assert(dst != NULL);
+  assert(src != NULL || n == 0);
+  assert(column + n <= columns);
+
+  for (size_t i = 0; i < n; ++i) {
+    // skip empty cells and cells covered by a form we already placed (or one
+    // that began outside `src`)
+    if (src[i] == NULL || src[i] == COVERED)
+      continue;
+    (void)raster_put(dst, columns, column + i, src[i]);
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "sprite.h"
+#include <stddef.h>
+
+/// a rasterised cell
+///
+/// A cell is either empty (`NULL`), the form displayed starting at that cell,
+/// or `COVERED` when it is hidden beneath the right side of a wide form to its
+/// left.
+typedef const form_t *cell_t;
+
+/// backing storage for `COVERED`
+extern const form_t raster_covered;
+
+/// marker for a cell covered by a wide form to its left
+#define COVERED (&raster_covered)
+
+/// place a form into a row of cells
+///
+/// Any wide forms partially overwritten by this are erased. A form that does
+/// not fit within the row is not placed.
+///
+/// \param row Cells to place into
+/// \param columns Number of cells in `row`
+/// \param column Index within `row` at which to place the form
+/// \param form Form to place
+/// \return Number of cells the form occupies, or 0 if it was not placed
+size_t raster_put(cell_t *row, size_t columns, size_t column,
+                  const form_t *form);
+
+/// composite cells onto a row
+///
+/// Non-empty cells from `src` are placed onto `dst` as if by `raster_put`,
+/// letting existing content of `dst` show through empty cells.
+///
+/// \param dst Row to composite onto
+/// \param columns Number of cells in `dst`
+/// \param column Index within `dst` at which `src` begins
+/// \param src Cells to composite
+/// \param n Number of cells in `src`
+void raster_composite(cell_t *dst, size_t columns, size_t column,
+                      const cell_t *src, size_t n);
@@ -0,0 +1,133 @@
+#include "record.h"
+#include <assert.h>
+#include <endgame/event.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/// identifying prefix of an event log
+static const char MAGIC[] = "EGEV\x01";
+
+/// serialise an unsigned integer as a LEB128 varint
+static size_t encode(unsigned char *dst, uint64_t v) {
+  assert(dst != NULL);
+
+  size_t n = 0;
+  do {
+    dst[n] = v & 0x7f;
+    v >>= 7;
+    if (v != 0)
+      dst[n] |= 0x80;
+    ++n;
+  } while (v != 0);
+
+  return n;
+}
+
+/// deserialise a LEB128 varint
+///
+/// \param log Stream to read from
+/// \param v [out] Decoded value
+/// \param first Is this the first field of a record?
+/// \return 0 on success or an errno on failure
+static int decode(FILE *log, uint64_t *v, bool first) {
+  assert(log != NULL);
+  assert(v != NULL);
+
+  *v = 0;
+  for (unsigned shift = 0;; shift += 7) {
+    const int c = getc(log);
+    if (c == EOF) {
+      if (ferror(log))
+        return EIO;
+      // running out of data between records is the normal end of a log
+      return first && shift == 0 ? ENODATA : EBADMSG;
+    }
+    if (shift > 63)
+      return EBADMSG;
+    *v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return 0;
+  }
+}
+
+int record_start(FILE *log) {
+  assert(log != NULL);
+
+  if (fwrite(MAGIC, 1, sizeof(MAGIC) - 1, log) < sizeof(MAGIC) - 1)
+    return EIO;
+
+  return 0;
+}
+
+int record_write(FILE *log, uint64_t delay, eg_event_t event) {
+  assert(log != NULL);
+
+  unsigned char buffer[10 + 1 + 10];
+  size_t len = encode(buffer, delay);
+  buffer[len++] = (unsigned char)event.type;
+  len += encode(&buffer[len], event.value);
+
+  if (fwrite(buffer, 1, len, log) < len)
+    return EIO;
+
+  return 0;
+}
+
+int record_open(FILE *log) {
+  assert(log != NULL);
+
+  char magic[sizeof(MAGIC) - 1];
+  if (fread(magic, 1, sizeof(magic), log) < sizeof(magic))
+    return ferror(log) ? EIO : EBADMSG;
+
+  if (memcmp(magic, MAGIC, sizeof(magic)) != 0)
+    return EBADMSG;
+
+  return 0;
+}
+
+int record_read(FILE *log, uint64_t *delay, eg_event_t *event) {
+  assert(log != NULL);
+  assert(delay != NULL);
+  assert(event != NULL);
+
+  int rc = 0;
+  int type;
+  while (true) {
+    if ((rc = decode(log, delay, true)))
+      return rc;
+
+    type = getc(log);
+    if (type == EOF)
+      return ferror(log) ? EIO : EBADMSG;
+
+    // A resumed log contains another header between records. This reads as a
+    // delay of 'E' followed by the type 'G', which is not a valid event type,
+    // so it cannot be mistaken for a record.
+    if (*delay != (unsigned char)MAGIC[0] || type != MAGIC[1])
+      break;
+    char rest[sizeof(MAGIC) - 3];
+    if (fread(rest, 1, sizeof(rest), log) < sizeof(rest))
+      return ferror(log) ? EIO : EBADMSG;
+    if (memcmp(rest, &MAGIC[2], sizeof(rest)) != 0)
+      return EBADMSG;
+  }
+
+  if (type > EG_EVENT_TIMER)
+    return EBADMSG;
+
+  uint64_t value;
+  if ((rc = decode(log, &value, false)))
+    return rc;
+  if (value > UINT32_MAX)
+    return EBADMSG;
+
+  *event =
+      (eg_event_t){.type = (eg_event_type_t)type, .value = (uint32_t)value};
+
+  return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <endgame/event.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// Event logs begin with a magic number, followed by a sequence of records.
+/// Each record is:
+///   1. the milliseconds since the previous record (or the start of
+///      recording), as a LEB128 varint;
+///   2. the event type, as a single byte; and
+///   3. the event value, as a LEB128 varint.
+/// Ticks and key presses in quick succession therefore take 3 bytes each.
+
+/// write the header of an event log
+///
+/// Recording may resume onto a log that already contains events, e.g. after
+/// stopping and restarting, in which case this header lands between records.
+/// `record_read` skips such repeated headers.
+///
+/// \param log Stream to write to
+/// \return 0 on success or an errno on failure
+int record_start(FILE *log);
+
+/// append an event to an event log
+///
+/// \param log Stream to write to
+/// \param delay Milliseconds since the previous event
+/// \param event Event to write
+/// \return 0 on success or an errno on failure
+int record_write(FILE *log, uint64_t delay, eg_event_t event);
+
+/// check the header of an event log
+///
+/// \param log Stream to read from
+/// \return 0 on success, `EBADMSG` if this is not an event log, or another
+///   errno on failure
+int record_open(FILE *log);
+
+/// read the next event from an event log
+///
+/// \param log Stream to read from
+/// \param delay [out] Milliseconds between the previous event and this one
+/// \param event [out] Event read
+/// \return 0 on success, `ENODATA` at the end of the log, `EBADMSG` if the log
+///   is malformed, or another errno on failure
+int record_read(FILE *log, uint64_t *delay, eg_event_t *event);
@@ -0,0 +1,139 @@
+#include "scan.h"
+#include "glyph.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#else
+#define SCAN_X86 0
+#endif
+
+static size_t mismatch_scalar(const glyph_t *a, const glyph_t *b, size_t n) {
+  size_t i = 0;
+  while (i < n && a[i] == b[i])
+    ++i;
+  return i;
+}
+
+static size_t run_scalar(const glyph_t *a, size_t n, glyph_t glyph) {
+  size_t i = 0;
+  while (i < n && a[i] == glyph)
+    ++i;
+  return i;
+}
+
+#if SCAN_X86
+
+/// index of the first clear bit within a byte mask from a vector compare
+///
+/// Each cell contributes 4 bits to the mask.
+static size_t first_clear(unsigned mask) {
+  return (size_t)__builtin_ctz(~mask) / sizeof(glyph_t);
+}
+
+// SSE2 is part of the x86-64 baseline, so needs no runtime check
+
+static size_t mismatch_sse2(const glyph_t *a, const glyph_t *b, size_t n) {
+  size_t i = 0;
+
+  // compare 8 cells per iteration, then find which of them differed
+  for (; i + 8 <= n; i += 8) {
+    const __m128i a0 = _mm_loadu_si128((const void *)&a[i]);
+    const __m128i a1 = _mm_loadu_si128((const void *)&a[i + 4]);
+    const __m128i b0 = _mm_loadu_si128((const void *)&b[i]);
+    const __m128i b1 = _mm_loadu_si128((const void *)&b[i + 4]);
+    const __m128i e0 = _mm_cmpeq_epi32(a0, b0);
+    const __m128i e1 = _mm_cmpeq_epi32(a1, b1);
+    if (_mm_movemask_epi8(_mm_and_si128(e0, e1)) == 0xffff)
+      continue;
+    const unsigned m0 = (unsigned)_mm_movemask_epi8(e0);
+    if (m0 != 0xffff)
+      return i + first_clear(m0);
+    return i + 4 + first_clear((unsigned)_mm_movemask_epi8(e1));
+  }
+
+  return i + mismatch_scalar(&a[i], &b[i], n - i);
+}
+
+static size_t run_sse2(const glyph_t *a, size_t n, glyph_t glyph) {
+  const __m128i g = _mm_set1_epi32((int)glyph);
+  size_t i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    const __m128i v = _mm_loadu_si128((const void *)&a[i]);
+    const unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi32(v, g));
+    if (m != 0xffff)
+      return i + first_clear(m);
+  }
+
+  return i + run_scalar(&a[i], n - i, glyph);
+}
+
+__attribute__((target("avx2"))) static size_t
+mismatch_avx2(const glyph_t *a, const glyph_t *b, size_t n) {
+  size_t i = 0;
+
+  // compare 16 cells per iteration, then find which of them differed
+  for (; i + 16 <= n; i += 16) {
+    const __m256i a0 = _mm256_loadu_si256((const void *)&a[i]);
+    const __m256i a1 = _mm256_loadu_si256((const void *)&a[i + 8]);
+    const __m256i b0 = _mm256_loadu_si256((const void *)&b[i]);
+    const __m256i b1 = _mm256_loadu_si256((const void *)&b[i + 8]);
+    const __m256i e0 = _mm256_cmpeq_epi32(a0, b0);
+    const __m256i e1 = _mm256_cmpeq_epi32(a1, b1);
+    if (_mm256_movemask_epi8(_mm256_and_si256(e0, e1)) == -1)
+      continue;
+    const unsigned m0 = (unsigned)_mm256_movemask_epi8(e0);
+    if (m0 != 0xffffffffu)
+      return i + first_clear(m0);
+    return i + 8 + first_clear((unsigned)_mm256_movemask_epi8(e1));
+  }
+
+  return i + mismatch_sse2(&a[i], &b[i], n - i);
+}
+
+__attribute__((target("avx2"))) static size_t
+run_avx2(const glyph_t *a, size_t n, glyph_t glyph) {
+  const __m256i g = _mm256_set1_epi32((int)glyph);
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const __m256i v = _mm256_loadu_si256((const void *)&a[i]);
+    const __m256i e = _mm256_cmpeq_epi32(v, g);
+    const unsigned m = (unsigned)_mm256_movemask_epi8(e);
+    if (m != 0xffffffffu)
+      return i + first_clear(m);
+  }
+
+  return i + run_sse2(&a[i], n - i, glyph);
+}
+
+#endif
+
+size_t scan_mismatch(const glyph_t *a, const glyph_t *b, size_t n) {
+  assert(a != NULL || n == 0);
+  assert(b != NULL || n == 0);
+
+#if SCAN_X86
+  if (__builtin_cpu_supports("avx2"))
+    return mismatch_avx2(a, b, n);
+  return mismatch_sse2(a, b, n);
+#else
+  return mismatch_scalar(a, b, n);
+#endif
+}
+
+size_t scan_run(const glyph_t *a, size_t n, glyph_t glyph) {
+  assert(a != NULL || n == 0);
+
+#if SCAN_X86
+  if (__builtin_cpu_supports("avx2"))
+    return run_avx2(a, n, glyph);
+  return run_sse2(a, n, glyph);
+#else
+  return run_scalar(a, n, glyph);
+#endif
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "glyph.h"
+#include <stddef.h>
+
+/// find the first position at which two runs of cells differ
+///
+/// On x86-64, this compares many cells at a time using whichever of AVX2 and
+/// SSE2 the CPU supports.
+///
+/// \param a First run of cells
+/// \param b Second run of cells
+/// \param n Number of cells in each of `a` and `b`
+/// \return Index of the first differing cell, or `n` if they are identical
+size_t scan_mismatch(const glyph_t *a, const glyph_t *b, size_t n);
+
+/// measure how many cells at the start of a run hold a given glyph
+///
+/// \param a Run of cells
+/// \param n Number of cells in `a`
+/// \param glyph Glyph to look for
+/// \return Number of leading cells equal to `glyph`
+size_t scan_run(const glyph_t *a, size_t n, glyph_t glyph);
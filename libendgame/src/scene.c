@@ -1,5 +1,12 @@
 #include "scene.h"
+#include "form.h"
+#include "frame.h"
+#include "io.h"
+#include "pool.h"
+#include "raster.h"
+#include "sort.h"
 #include "sprite.h"
+#include "tilemap.h"
 #include <assert.h>
 #include <endgame/io.h>
 #include <endgame/scene.h>
@@ -10,6 +17,82 @@
 #include <stdlib.h>
 #include <string.h>
 
+static void sprite_free(sprite_t *s) {
+
+  if (s == NULL)
+    return;
+
+  forms_free(s->forms, s->n_forms);
+
+  free(s);
+}
+
+static void layer_free(layer_t *l) {
+
+  if (l == NULL)
+    return;
+
+  for (size_t i = 0; i < l->n_sprites; ++i)
+    sprite_free(l->sprites[i]);
+  free(l->sprites);
+
+  for (size_t i = 0; i < l->n_tilemaps; ++i)
+    tilemap_free(l->tilemaps[i]);
+  free(l->tilemaps);
+
+  free(l->cache.cells);
+
+  free(l);
+}
+
+static int layer_new(layer_t **l, int64_t z, bool is_static) {
+  assert(l != NULL);
+
+  *l = NULL;
+  layer_t *ly = NULL;
+  int rc = 0;
+
+  ly = calloc(1, sizeof(*ly));
+  if (ly == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  ly->z = z;
+  ly->is_static = is_static;
+
+  *l = ly;
+  ly = NULL;
+
+done:
+  layer_free(ly);
+
+  return rc;
+}
+
+/// add a layer to a scene, maintaining z ordering
+static int insert_layer(eg_scene_t *me, layer_t *l) {
+  assert(me != NULL);
+  assert(l != NULL);
+
+  layer_t **const ls =
+      realloc(me->layers, (me->n_layers + 1) * sizeof(me->layers[0]));
+  if (ls == NULL)
+    return ENOMEM;
+  me->layers = ls;
+
+  // shuffle up any layers above this one
+  size_t i = me->n_layers;
+  while (i > 0 && me->layers[i - 1]->z > l->z) {
+    me->layers[i] = me->layers[i - 1];
+    --i;
+  }
+  me->layers[i] = l;
+  ++me->n_layers;
+
+  return 0;
+}
+
 int eg_scene_new(eg_scene_t **me) {
 
   if (me == NULL)
@@ -17,6 +100,7 @@ int eg_scene_new(eg_scene_t **me) {
 
   *me = NULL;
   eg_scene_t *s = NULL;
+  layer_t *base = NULL;
   int rc = 0;
 
   s = calloc(1, sizeof(*s));
@@ -25,15 +109,84 @@ int eg_scene_new(eg_scene_t **me) {
     goto done;
   }
 
+  if ((rc = layer_new(&base, 0, false)))
+    goto done;
+
+  if ((rc = insert_layer(s, base)))
+    goto done;
+  s->base = base;
+  base = NULL;
+
   *me = s;
   s = NULL;
 
 done:
+  layer_free(base);
   eg_scene_free(&s);
 
   return rc;
 }
 
+/// record a modification to a scene
+static void damage(eg_scene_t *me, rect_t area) {
+  assert(me != NULL);
+
+  ++me->generation;
+  me->damage[me->generation % DAMAGE_RING] = area;
+}
+
+/// area a form occupies when placed at a given position
+static rect_t extent(int64_t x, int64_t y, size_t width) {
+  const int64_t w = width > 1 ? (int64_t)width : 1;
+  return (rect_t){.left = x, .right = x + w - 1, .top = y, .bottom = y};
+}
+
+/// area a sprite currently occupies
+static rect_t sprite_extent(const sprite_t *s) {
+  assert(s != NULL);
+  return extent(s->x, s->y, s->forms[s->form].width);
+}
+
+/// current state of a sprite, as recorded in the journal
+static eg_placement_t placement(const sprite_t *s) {
+  assert(s != NULL);
+  return (eg_placement_t){.x = s->x, .y = s->y, .z = s->z, .form = s->form};
+}
+
+/// ensure there is room in a scene’s journal to record another change
+///
+/// This is done before modifying the scene, so a failure leaves it unaltered.
+static int journal_reserve(eg_scene_t *me) {
+  assert(me != NULL);
+
+  if (!me->journal.enabled)
+    return 0;
+
+  if (me->journal.n < me->journal.c)
+    return 0;
+
+  const size_t c = me->journal.c == 0 ? 256 : me->journal.c * 2;
+  eg_change_t *const cs = realloc(me->journal.changes, c * sizeof(cs[0]));
+  if (cs == NULL)
+    return ENOMEM;
+  me->journal.changes = cs;
+  me->journal.c = c;
+
+  return 0;
+}
+
+/// record a change in a scene’s journal, for which space has been reserved
+static void journal(eg_scene_t *me, eg_change_t change) {
+  assert(me != NULL);
+
+  if (!me->journal.enabled)
+    return;
+
+  assert(me->journal.n < me->journal.c);
+  me->journal.changes[me->journal.n] = change;
+  ++me->journal.n;
+}
+
 static int cmp(const void *a, const void *b) {
   const sprite_t *const *const xp = a;
   const sprite_t *const *const yp = b;
@@ -54,21 +207,33 @@ static int cmp(const void *a, const void *b) {
   return 0;
 }
 
-static void sort_sprites(eg_scene_t *me) {
-  assert(me != NULL);
-  qsort(me->sprites, me->n_sprites, sizeof(me->sprites[0]), cmp);
-}
+/// minimum number of sprites worth sorting in parallel
+static const size_t PARALLEL_SPRITES = 65536;
 
-static void sprite_free(sprite_t *s) {
-
-  if (s == NULL)
-    return;
+static void sort_sprites(eg_scene_t *me, layer_t *l) {
+  assert(me != NULL);
+  assert(l != NULL);
+
+  if (me->pool != NULL && l->n_sprites >= PARALLEL_SPRITES) {
+
+    // do we need to expand our sorting space?
+    if (l->n_sprites * 2 > me->c_keys) {
+      sort_key_t *const ks =
+          realloc(me->keys, l->n_sprites * 2 * sizeof(ks[0]));
+      if (ks != NULL) {
+        me->keys = ks;
+        me->c_keys = l->n_sprites * 2;
+      }
+    }
 
-  for (size_t i = 0; i < s->n_forms; ++i)
-    free(s->forms[i]);
-  free(s->forms);
+    // if we could not get the space we need, fall back to a serial sort
+    if (l->n_sprites * 2 <= me->c_keys) {
+      sort_parallel(l->sprites, l->n_sprites, me->keys, me->pool);
+      return;
+    }
+  }
 
-  free(s);
+  qsort(l->sprites, l->n_sprites, sizeof(l->sprites[0]), cmp);
 }
 
 static int sprite_new(sprite_t **s, const eg_sprite_t defn) {
@@ -84,23 +249,8 @@ static int sprite_new(sprite_t **s, const eg_sprite_t defn) {
     goto done;
   }
 
-  size_t n_forms = 0;
-  for (size_t i = 0; defn.forms[i] != NULL; ++i)
-    ++n_forms;
-  sp->forms = calloc(n_forms, sizeof(sp->forms[0]));
-  if (n_forms > 0 && sp->forms == NULL) {
-    rc = ENOMEM;
+  if ((rc = forms_new(&sp->forms, &sp->n_forms, defn.forms)))
     goto done;
-  }
-  sp->n_forms = n_forms;
-
-  for (size_t i = 0; i < n_forms; ++i) {
-    sp->forms[i] = strdup(defn.forms[i]);
-    if (sp->forms[i] == NULL) {
-      rc = ENOMEM;
-      goto done;
-    }
-  }
 
   *s = sp;
   sp = NULL;
@@ -111,12 +261,56 @@ done:
   return rc;
 }
 
+int eg_scene_add_layer(eg_scene_t *me, int64_t z, eg_layer_type_t type,
+                       eg_layer_handle_p *handle) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (type != EG_LAYER_DYNAMIC && type != EG_LAYER_STATIC)
+    return EINVAL;
+
+  if (handle == NULL)
+    return EINVAL;
+
+  *handle = NULL;
+  layer_t *l = NULL;
+  int rc = 0;
+
+  if ((rc = layer_new(&l, z, type == EG_LAYER_STATIC)))
+    goto done;
+
+  if ((rc = insert_layer(me, l)))
+    goto done;
+
+  *handle = l;
+  l = NULL;
+
+done:
+  layer_free(l);
+
+  return rc;
+}
+
 int eg_scene_add(eg_scene_t *me, int64_t x, int64_t y, int64_t z,
                  const eg_sprite_t *sprite, eg_sprite_handle_p *handle) {
 
   if (me == NULL)
     return EINVAL;
 
+  return eg_scene_add_to(me, me->base, x, y, z, sprite, handle);
+}
+
+int eg_scene_add_to(eg_scene_t *me, eg_layer_handle_p layer, int64_t x,
+                    int64_t y, int64_t z, const eg_sprite_t *sprite,
+                    eg_sprite_handle_p *handle) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (layer == NULL)
+    return EINVAL;
+
   if (sprite == NULL)
     return EINVAL;
 
@@ -127,44 +321,419 @@ int eg_scene_add(eg_scene_t *me, int64_t x, int64_t y, int64_t z,
     return EINVAL;
 
   *handle = NULL;
+  layer_t *l = layer;
   int rc = 0;
 
+  if ((rc = journal_reserve(me)))
+    goto done;
+
   // do we need to expand the sprite array?
-  if (me->n_sprites == me->c_sprites) {
-    const size_t c = me->c_sprites == 0 ? 1024 : me->c_sprites * 2;
-    sprite_t **const ss = realloc(me->sprites, c * sizeof(me->sprites[0]));
+  if (l->n_sprites == l->c_sprites) {
+    const size_t c = l->c_sprites == 0 ? 1024 : l->c_sprites * 2;
+    sprite_t **const ss = realloc(l->sprites, c * sizeof(l->sprites[0]));
     if (ss == NULL) {
       rc = ENOMEM;
       goto done;
     }
-    me->sprites = ss;
-    me->c_sprites = c;
+    l->sprites = ss;
+    l->c_sprites = c;
   }
 
   // add the new sprite
-  if ((rc = sprite_new(&me->sprites[me->n_sprites], *sprite)))
+  if ((rc = sprite_new(&l->sprites[l->n_sprites], *sprite)))
+    goto done;
+  l->sprites[l->n_sprites]->x = x;
+  l->sprites[l->n_sprites]->y = y;
+  l->sprites[l->n_sprites]->z = z;
+  l->sprites[l->n_sprites]->layer = l;
+  for (size_t i = 0; i < l->sprites[l->n_sprites]->n_forms; ++i) {
+    const size_t width = l->sprites[l->n_sprites]->forms[i].width;
+    if (width > l->max_width)
+      l->max_width = width;
+  }
+  ++l->n_sprites;
+
+  *handle = l->sprites[l->n_sprites - 1];
+
+  l->needs_sync = true;
+  l->cache.valid = false;
+  damage(me, sprite_extent(*handle));
+  journal(me, (eg_change_t){.type = EG_CHANGE_ADD,
+                            .sprite = *handle,
+                            .layer = l,
+                            .after = placement(*handle)});
+
+done:
+  return rc;
+}
+
+int eg_scene_add_tilemap(eg_scene_t *me, eg_layer_handle_p layer,
+                         const eg_sprite_t *palette,
+                         eg_tilemap_handle_p *handle) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (layer == NULL)
+    return EINVAL;
+
+  if (palette == NULL)
+    return EINVAL;
+
+  if (palette->forms == NULL)
+    return EINVAL;
+
+  if (handle == NULL)
+    return EINVAL;
+
+  *handle = NULL;
+  layer_t *l = layer;
+  tilemap_t *t = NULL;
+  int rc = 0;
+
+  if ((rc = tilemap_new(&t, palette->forms)))
     goto done;
-  me->sprites[me->n_sprites]->x = x;
-  me->sprites[me->n_sprites]->y = y;
-  me->sprites[me->n_sprites]->z = z;
-  ++me->n_sprites;
+  t->layer = l;
 
-  *handle = me->sprites[me->n_sprites - 1];
+  tilemap_t **const ts =
+      realloc(l->tilemaps, (l->n_tilemaps + 1) * sizeof(l->tilemaps[0]));
+  if (ts == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+  l->tilemaps = ts;
+  l->tilemaps[l->n_tilemaps] = t;
+  ++l->n_tilemaps;
+
+  *handle = t;
+  t = NULL;
 
-  me->needs_sync = true;
 done:
+  tilemap_free(t);
+
   return rc;
 }
 
+int eg_scene_set_tile(eg_scene_t *me, eg_tilemap_handle_p tilemap, int64_t x,
+                      int64_t y, eg_tile_t tile) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (tilemap == NULL)
+    return EINVAL;
+
+  tilemap_t *const t = tilemap;
+
+  const eg_tile_t old = tilemap_get(t, x, y);
+
+  const int rc = tilemap_set(t, x, y, tile);
+  if (rc != 0)
+    return rc;
+
+  t->layer->cache.valid = false;
+
+  // the affected area is that of whichever of the old and new tile is wider
+  const size_t old_width = old == 0 ? 1 : t->palette[old - 1].width;
+  const size_t new_width = tile == 0 ? 1 : t->palette[tile - 1].width;
+  damage(me, extent(x, y, old_width > new_width ? old_width : new_width));
+
+  return 0;
+}
+
+int eg_scene_get_tile(const eg_scene_t *me, eg_tilemap_handle_p tilemap,
+                      int64_t x, int64_t y, eg_tile_t *tile) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (tilemap == NULL)
+    return EINVAL;
+
+  if (tile == NULL)
+    return EINVAL;
+
+  *tile = tilemap_get(tilemap, x, y);
+
+  return 0;
+}
+
+/// find the first sprite in a layer positioned at or after a given point
+static size_t lower_bound(const layer_t *l, int64_t x, int64_t y) {
+  assert(l != NULL);
+
+  size_t lo = 0;
+  size_t hi = l->n_sprites;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    const sprite_t *const s = l->sprites[mid];
+    if (s->y < y || (s->y == y && s->x < x)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/// rasterise a layer onto a grid of cells
+///
+/// \param l Layer to rasterise
+/// \param cells Grid of `rows` × `columns` cells to draw onto
+/// \param columns Width of `cells`
+/// \param rows Height of `cells`
+/// \param origin Scene coordinates of the top left of `cells`
+static void rasterise(const layer_t *l, cell_t *cells, size_t columns,
+                      size_t rows, eg_2D_t origin) {
+  assert(l != NULL);
+  assert(cells != NULL || rows * columns == 0);
+
+  // tiles are displayed beneath sprites
+  for (size_t i = 0; i < l->n_tilemaps; ++i)
+    tilemap_rasterise(l->tilemaps[i], cells, columns, rows, origin);
+
+  const int64_t right = origin.x + (int64_t)columns;
+
+  for (size_t row = 0; row < rows; ++row) {
+    const int64_t y = origin.y + (int64_t)row;
+    cell_t *const r = &cells[row * columns];
+
+    // first column not hidden beneath a wide form from this layer
+    size_t uncovered = 0;
+
+    for (size_t i = lower_bound(l, origin.x, y); i < l->n_sprites; ++i) {
+      const sprite_t *const s = l->sprites[i];
+      if (s->y != y || s->x >= right)
+        break;
+
+      // only the top-most sprite at a given position is visible
+      if (i + 1 < l->n_sprites && l->sprites[i + 1]->y == y &&
+          l->sprites[i + 1]->x == s->x)
+        continue;
+
+      // skip sprites hidden beneath a wide form to their left
+      const size_t col = (size_t)(s->x - origin.x);
+      if (col < uncovered)
+        continue;
+
+      uncovered = col + raster_put(r, columns, col, &s->forms[s->form]);
+    }
+  }
+}
+
+/// maximum number of cells we are willing to cache for a static layer
+static const size_t CACHE_LIMIT = (size_t)1 << 24;
+
+/// rebuild the cached rasterisation of a static layer
+///
+/// If the layer spans too large an area to cache or we run out of memory, the
+/// cache is left empty and the layer will be rasterised on each paint instead.
+static void cache(layer_t *l) {
+  assert(l != NULL);
+  assert(l->is_static);
+  assert(!l->needs_sync);
+
+  free(l->cache.cells);
+  l->cache.cells = NULL;
+  l->cache.valid = true;
+
+  // find the bounding box of the layer’s sprites and tiles
+  bool any = false;
+  int64_t left = INT64_MAX;
+  int64_t right = INT64_MIN;
+  int64_t top = INT64_MAX;
+  int64_t bottom = INT64_MIN;
+  for (size_t i = 0; i < l->n_sprites; ++i) {
+    const sprite_t *const s = l->sprites[i];
+    const size_t width = s->forms[s->form].width;
+    const int64_t extent = width > 1 ? (int64_t)width - 1 : 0;
+    if (s->x < left)
+      left = s->x;
+    if (s->x + extent > right)
+      right = s->x + extent;
+    any = true;
+  }
+  if (l->n_sprites > 0) {
+    top = l->sprites[0]->y;
+    bottom = l->sprites[l->n_sprites - 1]->y;
+  }
+  for (size_t i = 0; i < l->n_tilemaps; ++i) {
+    const tilemap_t *const t = l->tilemaps[i];
+    if (!t->any)
+      continue;
+    if (t->left < left)
+      left = t->left;
+    if (t->right > right)
+      right = t->right;
+    if (t->top < top)
+      top = t->top;
+    if (t->bottom > bottom)
+      bottom = t->bottom;
+    any = true;
+  }
+  if (!any)
+    return;
+
+  const uint64_t columns = (uint64_t)right - (uint64_t)left + 1;
+  const uint64_t rows = (uint64_t)bottom - (uint64_t)top + 1;
+  if (columns == 0 || rows == 0)
+    return;
+  if (columns > CACHE_LIMIT || rows > CACHE_LIMIT / columns)
+    return;
+
+  cell_t *const cells = calloc(rows * columns, sizeof(cells[0]));
+  if (cells == NULL)
+    return;
+
+  l->cache.cells = cells;
+  l->cache.origin = (eg_2D_t){.x = left, .y = top};
+  l->cache.columns = columns;
+  l->cache.rows = rows;
+
+  rasterise(l, cells, columns, rows, l->cache.origin);
+}
+
+/// composite the cached rasterisation of a static layer onto a grid of cells
+///
+/// \param l Layer to composite
+/// \param cells Grid of `rows` × `columns` cells to draw onto
+/// \param columns Width of `cells`
+/// \param rows Height of `cells`
+/// \param origin Scene coordinates of the top left of `cells`
+static void composite(const layer_t *l, cell_t *cells, size_t columns,
+                      size_t rows, eg_2D_t origin) {
+  assert(l != NULL);
+  assert(l->cache.cells != NULL);
+  assert(cells != NULL || rows * columns == 0);
+
+  // find the horizontal overlap of the cache and the grid
+  const int64_t cache_left = l->cache.origin.x;
+  const int64_t cache_right = cache_left + (int64_t)l->cache.columns;
+  const int64_t left = cache_left > origin.x ? cache_left : origin.x;
+  const int64_t right = cache_right < origin.x + (int64_t)columns
+                            ? cache_right
+                            : origin.x + (int64_t)columns;
+  if (left >= right)
+    return;
+
+  for (size_t row = 0; row < rows; ++row) {
+    const int64_t y = origin.y + (int64_t)row;
+    if (y < l->cache.origin.y ||
+        y >= l->cache.origin.y + (int64_t)l->cache.rows)
+      continue;
+
+    const size_t src_row = (size_t)(y - l->cache.origin.y);
+    const cell_t *const src = &l->cache.cells[src_row * l->cache.columns +
+                                              (size_t)(left - cache_left)];
+    raster_composite(&cells[row * columns], columns,
+                     (size_t)(left - origin.x), src, (size_t)(right - left));
+  }
+}
+
 void eg_scene_sync(eg_scene_t *me) {
 
   if (me == NULL)
     return;
 
-  // make sure sprites are ordered consistently
-  sort_sprites(me);
+  for (size_t i = 0; i < me->n_layers; ++i) {
+    layer_t *const l = me->layers[i];
 
-  me->needs_sync = false;
+    // make sure sprites are ordered consistently
+    if (l->needs_sync) {
+      sort_sprites(me, l);
+      l->needs_sync = false;
+    }
+
+    // bring the rasterisation of static layers up to date
+    if (l->is_static && !l->cache.valid)
+      cache(l);
+  }
+}
+
+int eg_scene_set_threads(eg_scene_t *me, size_t threads) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  pool_free(&me->pool);
+
+  if (threads <= 1)
+    return 0;
+
+  return pool_new(&me->pool, threads - 1);
+}
+
+/// composite all layers of a scene onto a grid of cells
+///
+/// \param me Scene to composite
+/// \param cells Grid of `rows` × `columns` cells to draw onto
+/// \param columns Width of `cells`
+/// \param rows Height of `cells`
+/// \param origin Scene coordinates of the top left of `cells`
+static void compose(const eg_scene_t *me, cell_t *cells, size_t columns,
+                    size_t rows, eg_2D_t origin) {
+  assert(me != NULL);
+
+  memset(cells, 0, rows * columns * sizeof(cells[0]));
+
+  // composite layers, bottom first
+  for (size_t i = 0; i < me->n_layers; ++i) {
+    const layer_t *const l = me->layers[i];
+    if (l->cache.cells != NULL) {
+      composite(l, cells, columns, rows, origin);
+    } else {
+      rasterise(l, cells, columns, rows, origin);
+    }
+  }
+}
+
+/// a view box to be composited in horizontal bands
+typedef struct {
+  const eg_scene_t *scene;
+  cell_t *cells;
+  size_t columns;
+  size_t rows;
+  eg_2D_t origin;
+  size_t band; ///< number of rows per band
+} bands_t;
+
+/// composite a single band of a view box
+static void compose_band(void *ctx, size_t index) {
+  const bands_t *const b = ctx;
+  assert(b != NULL);
+
+  const size_t begin = index * b->band;
+  const size_t end = begin + b->band < b->rows ? begin + b->band : b->rows;
+  const eg_2D_t origin = {.x = b->origin.x, .y = b->origin.y + (int64_t)begin};
+
+  compose(b->scene, &b->cells[begin * b->columns], b->columns, end - begin,
+          origin);
+}
+
+/// minimum view box area worth compositing in parallel
+static const size_t PARALLEL_CELLS = 16384;
+
+void scene_compose(eg_scene_t *me, cell_t *cells, size_t columns, size_t rows,
+                   eg_2D_t origin) {
+  assert(me != NULL);
+  assert(cells != NULL || rows * columns == 0);
+
+  // Compositing only reads the (synchronised) scene and each band writes a
+  // disjoint part of the raster, so large view boxes can be split across
+  // threads.
+  if (me->pool != NULL && rows * columns >= PARALLEL_CELLS) {
+    // use a few bands per thread, to even out imbalanced work
+    const size_t bands = pool_size(me->pool) * 4;
+    bands_t b = {.scene = me,
+                 .cells = cells,
+                 .columns = columns,
+                 .rows = rows,
+                 .origin = origin,
+                 .band = (rows + bands - 1) / bands};
+    pool_run(me->pool, compose_band, &b, (rows + b.band - 1) / b.band);
+  } else {
+    compose(me, cells, columns, rows, origin);
+  }
 }
 
 int eg_scene_paint(eg_scene_t *me, eg_io_t *io, eg_2D_t origin) {
@@ -175,35 +744,36 @@ int eg_scene_paint(eg_scene_t *me, eg_io_t *io, eg_2D_t origin) {
   if (io == NULL)
     return EINVAL;
 
-  if (me->needs_sync)
-    eg_scene_sync(me);
+  eg_scene_sync(me);
 
   const size_t rows = eg_io_get_rows(io);
   const size_t columns = eg_io_get_columns(io);
 
-  size_t i = 0;
+  // do we need to expand our compositing space?
+  if (rows * columns > me->c_raster) {
+    cell_t *const r = realloc(me->raster, rows * columns * sizeof(r[0]));
+    if (r == NULL)
+      return ENOMEM;
+    me->raster = r;
+    me->c_raster = rows * columns;
+  }
+
+  scene_compose(me, me->raster, columns, rows, origin);
+
+  encoded_t blank = {.width = 1};
 
   for (size_t row = 0; row < rows; ++row) {
     for (size_t col = 0; col < columns; ++col) {
-      const int64_t rel_x = origin.x + (int64_t)col;
-      const int64_t rel_y = origin.y + (int64_t)row;
-
-      // find the sprite at this position
-      while (i < me->n_sprites && me->sprites[i]->y < rel_y)
-        ++i;
-      while (i < me->n_sprites && me->sprites[i]->y == rel_y &&
-             me->sprites[i]->x < rel_x)
-        ++i;
-      while (i + 1 < me->n_sprites && me->sprites[i + 1]->y == rel_y &&
-             me->sprites[i + 1]->x == rel_x)
-        ++i;
-
-      const char *s = (i < me->n_sprites && me->sprites[i]->y == rel_y &&
-                       me->sprites[i]->x == rel_x)
-                          ? me->sprites[i]->forms[me->sprites[i]->form]
-                          : NULL;
-
-      const int rc = eg_io_puts(io, col + 1, row + 1, s == NULL ? " " : s);
+      const cell_t c = me->raster[row * columns + col];
+
+      // skip cells displayed by the wide form to their left
+      if (c == COVERED)
+        continue;
+
+      const size_t x = col + 1;
+      const size_t y = row + 1;
+      const int rc = c == NULL ? io_put_encoded(io, x, y, &blank, 1)
+                               : io_put_encoded(io, x, y, c->cells, c->n_cells);
       if (rc != 0)
         return rc;
     }
@@ -212,6 +782,92 @@ int eg_scene_paint(eg_scene_t *me, eg_io_t *io, eg_2D_t origin) {
   return 0;
 }
 
+/// find the sprites in a layer intersecting an area
+///
+/// \param l Layer to search
+/// \param area Area to search
+/// \param handles [out] Storage for found sprites
+/// \param capacity Number of entries available in `handles`
+/// \param n [in,out] Number of sprites found so far
+static void query(const layer_t *l, rect_t area, eg_sprite_handle_p *handles,
+                  size_t capacity, size_t *n) {
+  assert(l != NULL);
+  assert(handles != NULL || capacity == 0);
+  assert(n != NULL);
+
+  // how far left of the area can a sprite start and still reach into it?
+  const int64_t reach = l->max_width > 1 ? (int64_t)l->max_width - 1 : 0;
+  const int64_t left =
+      area.left < INT64_MIN + reach ? INT64_MIN : area.left - reach;
+
+  // Visit each row of the area containing sprites, binary searching for the
+  // start of the candidates within it. Rows without sprites are skipped over
+  // by the search for the next candidate.
+  size_t i = lower_bound(l, left, area.top);
+  while (i < l->n_sprites) {
+    const sprite_t *const s = l->sprites[i];
+    if (s->y > area.bottom)
+      break;
+
+    // have we landed in a new row left of the candidates?
+    if (s->x < left) {
+      i = lower_bound(l, left, s->y);
+      continue;
+    }
+
+    // have we passed the candidates in this row?
+    if (s->x > area.right) {
+      if (s->y == INT64_MAX)
+        break;
+      i = lower_bound(l, left, s->y + 1);
+      continue;
+    }
+
+    if (sprite_extent(s).right >= area.left) {
+      if (*n < capacity)
+        handles[*n] = l->sprites[i];
+      ++*n;
+    }
+    ++i;
+  }
+}
+
+int eg_scene_query_rect(eg_scene_t *me, eg_2D_t top_left,
+                        eg_2D_t bottom_right, eg_sprite_handle_p *handles,
+                        size_t capacity, size_t *n) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (handles == NULL && capacity > 0)
+    return EINVAL;
+
+  if (n == NULL)
+    return EINVAL;
+
+  *n = 0;
+
+  if (top_left.x > bottom_right.x || top_left.y > bottom_right.y)
+    return 0;
+
+  eg_scene_sync(me);
+
+  const rect_t area = {.left = top_left.x,
+                       .right = bottom_right.x,
+                       .top = top_left.y,
+                       .bottom = bottom_right.y};
+  for (size_t i = 0; i < me->n_layers; ++i)
+    query(me->layers[i], area, handles, capacity, n);
+
+  return 0;
+}
+
+int eg_scene_query_point(eg_scene_t *me, eg_2D_t point,
+                         eg_sprite_handle_p *handles, size_t capacity,
+                         size_t *n) {
+  return eg_scene_query_rect(me, point, point, handles, capacity, n);
+}
+
 int eg_scene_move(eg_scene_t *me, eg_sprite_handle_p subject, int64_t x,
                   int64_t y, int64_t z) {
 
@@ -223,11 +879,25 @@ int eg_scene_move(eg_scene_t *me, eg_sprite_handle_p subject, int64_t x,
 
   sprite_t *sprite = subject;
 
+  const int rc = journal_reserve(me);
+  if (rc != 0)
+    return rc;
+
+  const eg_placement_t before = placement(sprite);
+  damage(me, sprite_extent(sprite));
+
   sprite->x = x;
   sprite->y = y;
   sprite->z = z;
 
-  me->needs_sync = true;
+  sprite->layer->needs_sync = true;
+  sprite->layer->cache.valid = false;
+  damage(me, sprite_extent(sprite));
+  journal(me, (eg_change_t){.type = EG_CHANGE_MOVE,
+                            .sprite = sprite,
+                            .layer = sprite->layer,
+                            .before = before,
+                            .after = placement(sprite)});
 
   return 0;
 }
@@ -245,7 +915,23 @@ int eg_scene_morph(eg_scene_t *me, eg_sprite_handle_p subject, size_t form) {
   if (form >= sprite->n_forms)
     return ERANGE;
 
+  const int rc = journal_reserve(me);
+  if (rc != 0)
+    return rc;
+
+  const eg_placement_t before = placement(sprite);
+  damage(me, sprite_extent(sprite));
+
   sprite->form = form;
+  damage(me, sprite_extent(sprite));
+  journal(me, (eg_change_t){.type = EG_CHANGE_MORPH,
+                            .sprite = sprite,
+                            .layer = sprite->layer,
+                            .before = before,
+                            .after = placement(sprite)});
+
+  // the sprites are still ordered, but any cached rasterisation is not valid
+  sprite->layer->cache.valid = false;
 
   return 0;
 }
@@ -258,18 +944,33 @@ int eg_scene_remove(eg_scene_t *me, eg_sprite_handle_p handle) {
   if (handle == NULL)
     return EINVAL;
 
+  const sprite_t *const sprite = handle;
+  layer_t *const l = sprite->layer;
+
+  const int rc = journal_reserve(me);
+  if (rc != 0)
+    return rc;
+
   // FIXME: this scan will be expensive in large scenes
-  for (size_t i = 0; i < me->n_sprites; ++i) {
-    if (me->sprites[i] == handle) {
+  for (size_t i = 0; i < l->n_sprites; ++i) {
+    if (l->sprites[i] == handle) {
+      damage(me, sprite_extent(sprite));
+      journal(me, (eg_change_t){.type = EG_CHANGE_REMOVE,
+                                .sprite = handle,
+                                .layer = l,
+                                .before = placement(sprite)});
       sprite_free(handle);
-      for (size_t j = i; j + 1 < me->n_sprites; ++j)
-        me->sprites[j] = me->sprites[j + 1];
-      --me->n_sprites;
+      ++me->epoch;
+      for (size_t j = i; j + 1 < l->n_sprites; ++j)
+        l->sprites[j] = l->sprites[j + 1];
+      --l->n_sprites;
 
       // Technically we do not need to set `needs_sync` here because the sprite
       // array is still ordered. But we keep this as part of the API contract
       // just in case future changes make this necessary.
 
+      l->cache.valid = false;
+
       return 0;
     }
   }
@@ -278,6 +979,49 @@ int eg_scene_remove(eg_scene_t *me, eg_sprite_handle_p handle) {
   return ENOENT;
 }
 
+int eg_scene_set_journal(eg_scene_t *me, bool enable) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (!enable) {
+    free(me->journal.changes);
+    me->journal.changes = NULL;
+    me->journal.n = 0;
+    me->journal.c = 0;
+  }
+
+  me->journal.enabled = enable;
+
+  return 0;
+}
+
+int eg_scene_get_changes(const eg_scene_t *me, const eg_change_t **changes,
+                         size_t *n) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (changes == NULL)
+    return EINVAL;
+
+  if (n == NULL)
+    return EINVAL;
+
+  *changes = me->journal.changes;
+  *n = me->journal.n;
+
+  return 0;
+}
+
+void eg_scene_clear_changes(eg_scene_t *me) {
+
+  if (me == NULL)
+    return;
+
+  me->journal.n = 0;
+}
+
 void eg_scene_free(eg_scene_t **me) {
 
   if (me == NULL)
@@ -286,9 +1030,16 @@ void eg_scene_free(eg_scene_t **me) {
   if (*me == NULL)
     return;
 
-  for (size_t i = 0; i < (*me)->n_sprites; ++i)
-    sprite_free((*me)->sprites[i]);
-  free((*me)->sprites);
+  for (size_t i = 0; i < (*me)->n_layers; ++i)
+    layer_free((*me)->layers[i]);
+  free((*me)->layers);
+
+  free((*me)->raster);
+
+  pool_free(&(*me)->pool);
+  free((*me)->keys);
+
+  free((*me)->journal.changes);
 
   free(*me);
   *me = NULL;
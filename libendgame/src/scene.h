@@ -1,18 +1,123 @@
 #pragma once
 
+#include "pool.h"
+#include "raster.h"
+#include "sort.h"
 #include "sprite.h"
+#include "tilemap.h"
 #include <endgame/scene.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
-struct eg_scene {
-  /// sprites in this scene, ordered by {y,x,z}
+/// a layer of sprites within a scene
+struct layer {
+  int64_t z;      ///< stacking order relative to other layers
+  bool is_static; ///< should this layer’s rasterisation be cached?
+
+  /// sprites in this layer, ordered by {y,x,z}
   ///
   /// We store an array of sprites rather than a grid of cells under the
-  /// assumption that scenes are sparse. That is, most cells will be empty.
+  /// assumption that sprites are sparse. That is, most cells will be empty.
+  /// Dense content is expected to be stored in `tilemaps` instead.
   sprite_t **sprites;
   size_t n_sprites;
   size_t c_sprites;
 
+  /// tilemaps in this layer, displayed beneath its sprites in the order they
+  /// were added
+  tilemap_t **tilemaps;
+  size_t n_tilemaps;
+
   bool needs_sync; ///< are the sprites potentially unsorted?
+
+  /// widest form of any sprite ever added to this layer
+  ///
+  /// Queries use this to bound how far to the left of an area a sprite can be
+  /// positioned while still covering part of it.
+  size_t max_width;
+
+  /// cached rasterisation of a static layer
+  ///
+  /// This covers the bounding box of all the layer’s sprites and tiles. It is
+  /// rebuilt during synchronisation whenever the layer has been modified.
+  struct {
+    cell_t *cells;  ///< `rows` × `columns` cells
+    eg_2D_t origin; ///< scene coordinates of the top left cell
+    size_t columns;
+    size_t rows;
+    bool valid; ///< does `cells` reflect the current sprites?
+  } cache;
+};
+
+typedef struct layer layer_t;
+
+/// number of recent modifications whose location a scene remembers
+#define DAMAGE_RING 256
+
+/// an inclusive rectangle of scene coordinates
+typedef struct {
+  int64_t left;
+  int64_t right;
+  int64_t top;
+  int64_t bottom;
+} rect_t;
+
+struct eg_scene {
+  /// layers in this scene, ordered by z
+  ///
+  /// Layers at equal z are kept in the order in which they were added.
+  layer_t **layers;
+  size_t n_layers;
+
+  layer_t *base; ///< default layer that `eg_scene_add` places sprites into
+
+  /// scratch space for compositing a view box
+  cell_t *raster;
+  size_t c_raster;
+
+  pool_t *pool; ///< optional workers for painting and sorting in parallel
+
+  /// scratch space for sorting sprites in parallel
+  sort_key_t *keys;
+  size_t c_keys;
+
+  /// number of modifications made to this scene
+  ///
+  /// Anything caching a rasterisation of the scene can compare this against
+  /// the value it saw to determine whether it is stale.
+  uint64_t generation;
+
+  /// areas affected by the most recent modifications
+  ///
+  /// The area affected by modification `g` is at `damage[g % DAMAGE_RING]`, as
+  /// long as `generation - g < DAMAGE_RING`.
+  rect_t damage[DAMAGE_RING];
+
+  /// number of times a sprite’s forms have been freed
+  ///
+  /// A later form may be allocated at a freed form’s address, so anything
+  /// remembering forms by address must forget them when this changes.
+  uint64_t epoch;
+
+  /// log of sprite modifications, for `eg_scene_get_changes`
+  struct {
+    eg_change_t *changes;
+    size_t n;
+    size_t c;
+    bool enabled;
+  } journal;
 };
+
+/// composite a view box of a scene onto a grid of cells
+///
+/// The scene must be synchronised. Large view boxes are composited in parallel
+/// if the scene has threads available.
+///
+/// \param me Scene to composite
+/// \param cells Grid of `rows` × `columns` cells to draw onto
+/// \param columns Width of `cells`
+/// \param rows Height of `cells`
+/// \param origin Scene coordinates of the top left of `cells`
+void scene_compose(eg_scene_t *me, cell_t *cells, size_t columns, size_t rows,
+                   eg_2D_t origin);
@@ -0,0 +1,186 @@
+#include "sort.h"
+#include "pool.h"
+#include "sprite.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// bias a signed coordinate so it orders correctly as unsigned
+static uint64_t bias(int64_t v) {
+  return (uint64_t)v ^ (UINT64_C(1) << 63);
+}
+
+static bool less(const sort_key_t *a, const sort_key_t *b) {
+  if (a->y != b->y)
+    return a->y < b->y;
+  if (a->x != b->x)
+    return a->x < b->x;
+  return a->z < b->z;
+}
+
+/// merge two sorted runs
+static void merge(sort_key_t *dst, const sort_key_t *a, size_t m,
+                  const sort_key_t *b, size_t n) {
+  size_t i = 0;
+  size_t j = 0;
+  while (i < m && j < n) {
+    if (less(&b[j], &a[i])) {
+      *dst++ = b[j++];
+    } else {
+      *dst++ = a[i++];
+    }
+  }
+  memcpy(dst, &a[i], (m - i) * sizeof(a[0]));
+  dst += m - i;
+  memcpy(dst, &b[j], (n - j) * sizeof(b[0]));
+}
+
+/// length of runs sorted by insertion before merging
+enum { RUN = 16 };
+
+/// sort keys, using `tmp` as scratch space of equal length
+static void sort(sort_key_t *keys, sort_key_t *tmp, size_t n) {
+
+  // insertion sort short runs
+  for (size_t start = 0; start < n; start += RUN) {
+    const size_t end = start + RUN < n ? start + RUN : n;
+    for (size_t i = start + 1; i < end; ++i) {
+      const sort_key_t k = keys[i];
+      size_t j = i;
+      for (; j > start && less(&k, &keys[j - 1]); --j)
+        keys[j] = keys[j - 1];
+      keys[j] = k;
+    }
+  }
+
+  // merge runs bottom up, alternating between the two buffers
+  sort_key_t *src = keys;
+  sort_key_t *dst = tmp;
+  for (size_t width = RUN; width < n; width *= 2) {
+    for (size_t start = 0; start < n; start += 2 * width) {
+      const size_t mid = start + width < n ? start + width : n;
+      const size_t end = mid + width < n ? mid + width : n;
+      merge(&dst[start], &src[start], mid - start, &src[mid], end - mid);
+    }
+    sort_key_t *const t = src;
+    src = dst;
+    dst = t;
+  }
+
+  if (src != keys)
+    memcpy(keys, src, n * sizeof(keys[0]));
+}
+
+/// find how many elements of `a` are among the first `i` of merging `a`, `b`
+static size_t corank(size_t i, const sort_key_t *a, size_t m,
+                     const sort_key_t *b, size_t n) {
+  size_t lo = i > n ? i - n : 0;
+  size_t hi = i < m ? i : m;
+  while (lo < hi) {
+    const size_t j = lo + (hi - lo) / 2;
+    // is the next element of `a` smaller than the last we would take of `b`?
+    if (j < m && i - j > 0 && less(&a[j], &b[i - j - 1])) {
+      lo = j + 1;
+    } else {
+      hi = j;
+    }
+  }
+  return lo;
+}
+
+/// state shared by all tasks of a parallel sort
+typedef struct {
+  sprite_t **sprites;
+  size_t n;
+  size_t chunks; ///< number of initially sorted chunks, a power of 2
+
+  sort_key_t *src; ///< keys being merged from
+  sort_key_t *dst; ///< keys being merged into
+  size_t width;    ///< number of chunks in each run being merged
+  size_t pieces;   ///< number of tasks each merge is split into
+} job_t;
+
+/// index of the start of a given chunk
+static size_t chunk_start(const job_t *job, size_t chunk) {
+  const size_t base = job->n / job->chunks;
+  const size_t extra = job->n % job->chunks;
+  return base * chunk + (chunk < extra ? chunk : extra);
+}
+
+/// create and sort the keys for a single chunk
+static void sort_chunk(void *ctx, size_t index) {
+  const job_t *const job = ctx;
+  assert(job != NULL);
+
+  const size_t start = chunk_start(job, index);
+  const size_t end = chunk_start(job, index + 1);
+
+  for (size_t i = start; i < end; ++i) {
+    sprite_t *const s = job->sprites[i];
+    job->src[i] = (sort_key_t){
+        .y = bias(s->y), .x = bias(s->x), .z = bias(s->z), .sprite = s};
+  }
+
+  sort(&job->src[start], &job->dst[start], end - start);
+}
+
+/// merge a piece of a pair of runs
+static void merge_piece(void *ctx, size_t index) {
+  const job_t *const job = ctx;
+  assert(job != NULL);
+
+  const size_t pair = index / job->pieces;
+  const size_t piece = index % job->pieces;
+
+  const size_t start = chunk_start(job, pair * 2 * job->width);
+  const size_t mid = chunk_start(job, pair * 2 * job->width + job->width);
+  const size_t end = chunk_start(job, (pair + 1) * 2 * job->width);
+
+  const sort_key_t *const a = &job->src[start];
+  const size_t m = mid - start;
+  const sort_key_t *const b = &job->src[mid];
+  const size_t n = end - mid;
+
+  // find the range of the output this piece is responsible for
+  const size_t lo = (m + n) / job->pieces * piece;
+  const size_t hi =
+      piece + 1 == job->pieces ? m + n : (m + n) / job->pieces * (piece + 1);
+  const size_t a_lo = corank(lo, a, m, b, n);
+  const size_t a_hi = corank(hi, a, m, b, n);
+
+  merge(&job->dst[start + lo], &a[a_lo], a_hi - a_lo, &b[lo - a_lo],
+        (hi - a_hi) - (lo - a_lo));
+}
+
+void sort_parallel(sprite_t **sprites, size_t n, sort_key_t *scratch,
+                   pool_t *pool) {
+  assert(sprites != NULL || n == 0);
+  assert(scratch != NULL || n == 0);
+  assert(pool != NULL);
+
+  const size_t threads = pool_size(pool);
+
+  job_t job = {.sprites = sprites, .n = n, .src = scratch, .dst = &scratch[n]};
+
+  // use a power of 2 chunks, so they can be merged pairwise
+  job.chunks = 1;
+  while (job.chunks < threads)
+    job.chunks *= 2;
+
+  pool_run(pool, sort_chunk, &job, job.chunks);
+
+  for (job.width = 1; job.width < job.chunks; job.width *= 2) {
+    const size_t pairs = job.chunks / job.width / 2;
+    job.pieces = (threads + pairs - 1) / pairs;
+    pool_run(pool, merge_piece, &job, pairs * job.pieces);
+
+    sort_key_t *const t = job.src;
+    job.src = job.dst;
+    job.dst = t;
+  }
+
+  for (size_t i = 0; i < n; ++i)
+    sprites[i] = job.src[i].sprite;
+}
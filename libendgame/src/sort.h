@@ -0,0 +1,30 @@
+#pragma once
+
+#include "pool.h"
+#include "sprite.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/// a sprite’s position, packed for sorting
+///
+/// Coordinates are biased into unsigned integers, so that keys can be ordered
+/// by plain unsigned comparison of {y,x,z}.
+typedef struct {
+  uint64_t y;
+  uint64_t x;
+  uint64_t z;
+  sprite_t *sprite;
+} sort_key_t;
+
+/// sort sprites by {y,x,z} using a pool of threads
+///
+/// The sprites are split into a chunk per thread, each of which is sorted
+/// independently. The sorted chunks are then merged pairwise, with each merge
+/// itself split across threads.
+///
+/// \param sprites Sprites to sort
+/// \param n Number of entries in `sprites`
+/// \param scratch Space for 2 × `n` keys
+/// \param pool Threads to sort with
+void sort_parallel(sprite_t **sprites, size_t n, sort_key_t *scratch,
+                   pool_t *pool);
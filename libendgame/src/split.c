@@ -0,0 +1,304 @@
+#include "split.h"
+#include "width.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// reset of SGR attributes, appended to cells that have them
+static const char RESET[] = "\033[0m";
+
+/// parameters of an SGR sequence, read one at a time
+typedef struct {
+  const char *s; ///< parameter bytes, between “\033[” and “m”
+  size_t len;    ///< number of bytes in `s`
+  size_t i;      ///< offset of the next parameter, or > `len` when done
+} params_t;
+
+/// is this escape sequence SGR, rather than some other control sequence?
+static bool is_sgr(const char *text, size_t len) {
+  if (len < 3 || text[1] != '[' || text[len - 1] != 'm')
+    return false;
+  for (size_t i = 2; i + 1 < len; ++i) {
+    if (!(text[i] >= '0' && text[i] <= '9') && text[i] != ';' && text[i] != ':')
+      return false;
+  }
+  return true;
+}
+
+/// read the next parameter, where an empty one means 0
+///
+/// \param p Parameters to read from
+/// \param value [out] The parameter
+/// \param sub [out] Whether this is a sub-parameter (i.e. follows a ':')
+/// \return True if there was another parameter
+static bool next_param(params_t *p, unsigned *value, bool *sub) {
+  assert(p != NULL);
+  assert(value != NULL);
+  assert(sub != NULL);
+
+  if (p->i > p->len)
+    return false;
+
+  *sub = p->i > 0 && p->s[p->i - 1] == ':';
+  *value = 0;
+  for (; p->i < p->len && p->s[p->i] != ';' && p->s[p->i] != ':'; ++p->i) {
+    if (*value < UINT16_MAX)
+      *value = *value * 10 + (unsigned)(p->s[p->i] - '0');
+  }
+  ++p->i;
+
+  return true;
+}
+
+/// read an extended colour, following a 38, 48 or 58
+///
+/// Both the original “38;5;n” form and the ITU T.416 “38:5:n” form are
+/// accepted, the latter with or without a colour space identifier.
+static sgr_colour_t read_colour(params_t *p) {
+  assert(p != NULL);
+
+  unsigned v[6] = {0};
+  size_t n = 0;
+  bool sub;
+  params_t peek = *p;
+
+  if (next_param(&peek, &v[0], &sub) && sub) {
+    // colon form: take every sub-parameter
+    *p = peek;
+    n = 1;
+    for (peek = *p; next_param(&peek, &v[n < 5 ? n : 5], &sub) && sub;
+         peek = *p) {
+      *p = peek;
+      ++n;
+    }
+    if (v[0] == 2 && n >= 5) { // skip the colour space identifier
+      v[1] = v[2];
+      v[2] = v[3];
+      v[3] = v[4];
+    }
+  } else {
+    // semicolon form: the selector says how many parameters follow
+    if (!next_param(p, &v[0], &sub))
+      return (sgr_colour_t){0};
+    const size_t want = v[0] == 5 ? 1 : v[0] == 2 ? 3 : 0;
+    for (n = 1; n <= want && next_param(p, &v[n], &sub); ++n)
+      ;
+  }
+
+  for (size_t i = 1; i < sizeof(v) / sizeof(v[0]); ++i)
+    v[i] = v[i] > UINT8_MAX ? UINT8_MAX : v[i];
+
+  if (v[0] == 5 && n >= 2)
+    return (sgr_colour_t){SGR_INDEXED, {(uint8_t)v[1]}};
+  if (v[0] == 2 && n >= 4)
+    return (sgr_colour_t){SGR_RGB,
+                          {(uint8_t)v[1], (uint8_t)v[2], (uint8_t)v[3]}};
+  return (sgr_colour_t){0};
+}
+
+/// update attributes from an SGR sequence
+static void apply(sgr_t *sgr, const char *text, size_t len) {
+  assert(sgr != NULL);
+  assert(is_sgr(text, len));
+
+  params_t p = {.s = &text[2], .len = len - 3};
+  unsigned v;
+  bool sub;
+  while (next_param(&p, &v, &sub)) {
+    if (sub) {
+      // a sub-parameter of something we do not understand
+    } else if (v == 0) {
+      *sgr = (sgr_t){0};
+    } else if (v == 4 && p.i <= p.len && p.s[p.i - 1] == ':') {
+      unsigned style = 0;
+      (void)next_param(&p, &style, &sub);
+      sgr->style[4] = (uint8_t)(style > 5 ? 1 : style);
+    } else if (v < 10) {
+      sgr->style[v] = 1;
+    } else if (v == 21) {
+      sgr->style[4] = 2; // double underline
+    } else if (v == 22) {
+      sgr->style[1] = sgr->style[2] = 0;
+    } else if (v == 25) {
+      sgr->style[5] = sgr->style[6] = 0;
+    } else if (v >= 23 && v <= 29 && v != 26) {
+      sgr->style[v - 20] = 0;
+    } else if ((v >= 30 && v <= 37) || (v >= 90 && v <= 97)) {
+      sgr->fg = (sgr_colour_t){SGR_BASIC, {(uint8_t)v}};
+    } else if ((v >= 40 && v <= 47) || (v >= 100 && v <= 107)) {
+      sgr->bg = (sgr_colour_t){SGR_BASIC, {(uint8_t)v}};
+    } else if (v == 38) {
+      sgr->fg = read_colour(&p);
+    } else if (v == 48) {
+      sgr->bg = read_colour(&p);
+    } else if (v == 58) {
+      sgr->ul = read_colour(&p);
+    } else if (v == 39) {
+      sgr->fg = (sgr_colour_t){0};
+    } else if (v == 49) {
+      sgr->bg = (sgr_colour_t){0};
+    } else if (v == 59) {
+      sgr->ul = (sgr_colour_t){0};
+    } else if (v == 53) {
+      sgr->overline = true;
+    } else if (v == 55) {
+      sgr->overline = false;
+    }
+    // anything else is unknown to us, so is ignored
+  }
+}
+
+/// append a parameter to the SGR sequence being rendered
+static void put(split_t *me, unsigned value, char separator) {
+  assert(me != NULL);
+  assert(value <= 255);
+
+  char digits[4];
+  size_t n = 0;
+  do {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  assert(me->attr_len + n + 1 <= sizeof(me->attr));
+  while (n > 0)
+    me->attr[me->attr_len++] = digits[--n];
+  me->attr[me->attr_len++] = separator;
+}
+
+/// append a colour to the SGR sequence being rendered
+static void put_colour(split_t *me, unsigned base, const sgr_colour_t *c) {
+  assert(me != NULL);
+  assert(c != NULL);
+
+  switch (c->kind) {
+  case SGR_DEFAULT:
+    break;
+  case SGR_BASIC:
+    put(me, c->value[0], ';');
+    break;
+  case SGR_INDEXED:
+    put(me, base, ';');
+    put(me, 5, ';');
+    put(me, c->value[0], ';');
+    break;
+  case SGR_RGB:
+    put(me, base, ';');
+    put(me, 2, ';');
+    for (size_t i = 0; i < sizeof(c->value); ++i)
+      put(me, c->value[i], ';');
+    break;
+  }
+}
+
+/// render the attributes in effect as a single SGR sequence
+static void render(split_t *me) {
+  assert(me != NULL);
+
+  me->attr_len = 0;
+  me->attr[me->attr_len++] = '\033';
+  me->attr[me->attr_len++] = '[';
+
+  const sgr_t *const sgr = &me->sgr;
+  for (unsigned i = 1; i < sizeof(sgr->style); ++i) {
+    if (sgr->style[i] == 0)
+      continue;
+    if (i == 4 && sgr->style[i] != 1) {
+      put(me, i, ':');
+      put(me, sgr->style[i], ';');
+    } else {
+      put(me, i, ';');
+    }
+  }
+  if (sgr->overline)
+    put(me, 53, ';');
+  put_colour(me, 38, &sgr->fg);
+  put_colour(me, 48, &sgr->bg);
+  put_colour(me, 58, &sgr->ul);
+
+  // nothing in effect needs no sequence at all
+  if (me->attr_len == 2) {
+    me->attr_len = 0;
+    return;
+  }
+
+  // replace the trailing separator with the final byte
+  me->attr[me->attr_len - 1] = 'm';
+}
+
+void split_init(split_t *me, const char *text, size_t len) {
+  assert(me != NULL);
+  assert(text != NULL || len == 0);
+
+  me->text = text;
+  me->len = len;
+  me->offset = 0;
+  me->sgr = (sgr_t){0};
+  me->attr_len = 0;
+}
+
+bool split_next(split_t *me, const char **cluster, size_t *len,
+                size_t *width) {
+  assert(me != NULL);
+  assert(cluster != NULL);
+  assert(len != NULL);
+  assert(width != NULL);
+
+  while (me->offset < me->len) {
+    const char *const t = &me->text[me->offset];
+    const size_t remaining = me->len - me->offset;
+
+    if (t[0] == 0x1b) {
+      const size_t n = escape_length(t, remaining);
+      // other escape sequences are meaningless once split into cells
+      if (is_sgr(t, n)) {
+        apply(&me->sgr, t, n);
+        render(me);
+      }
+      me->offset += n;
+      continue;
+    }
+
+    const size_t n = next_cluster(t, remaining, width);
+    me->offset += n;
+
+    // drop anything that would not occupy a cell of its own
+    if (*width == 0)
+      continue;
+
+    *cluster = t;
+    *len = n;
+    return true;
+  }
+
+  return false;
+}
+
+bool split_is_blank(const split_t *me, const char *cluster, size_t len) {
+  assert(me != NULL);
+  assert(cluster != NULL);
+
+  return me->attr_len == 0 && len == 1 && cluster[0] == ' ';
+}
+
+size_t split_encoded_len(const split_t *me, size_t len) {
+  assert(me != NULL);
+
+  if (me->attr_len == 0)
+    return len;
+  return me->attr_len + len + sizeof(RESET) - 1;
+}
+
+void split_encode(const split_t *me, const char *cluster, size_t len,
+                  char *dst) {
+  assert(me != NULL);
+  assert(cluster != NULL);
+  assert(dst != NULL);
+
+  memcpy(dst, me->attr, me->attr_len);
+  memcpy(&dst[me->attr_len], cluster, len);
+  if (me->attr_len > 0)
+    memcpy(&dst[me->attr_len + len], RESET, sizeof(RESET) - 1);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// a colour set by SGR
+typedef struct {
+  enum {
+    SGR_DEFAULT = 0, ///< the terminal's default
+    SGR_BASIC,       ///< one of the 16 basic colours, `value[0]` is its code
+    SGR_INDEXED,     ///< palette entry `value[0]`
+    SGR_RGB,         ///< 24-bit colour `value[0]`, `value[1]`, `value[2]`
+  } kind;
+  uint8_t value[3]; ///< see `kind`
+} sgr_colour_t;
+
+/// the SGR attributes in effect at some point in some text
+typedef struct {
+  /// state of each of SGR 1–9 (bold through strikethrough), indexed by code,
+  /// 0 if off; for underline (4) this is the underline style
+  uint8_t style[10];
+  bool overline;   ///< SGR 53
+  sgr_colour_t fg; ///< foreground colour
+  sgr_colour_t bg; ///< background colour
+  sgr_colour_t ul; ///< underline colour
+} sgr_t;
+
+/// state for splitting text into the cells it occupies on a terminal
+///
+/// SGR sequences in the text do not occupy cells of their own, but apply to
+/// each cell following them until changed or reset. Other escape sequences
+/// (e.g. cursor movement) are dropped, as they do not mean the same thing once
+/// the text is split into cells.
+typedef struct {
+  const char *text; ///< text being split
+  size_t len;       ///< number of bytes in `text`
+  size_t offset;    ///< how far through `text` splitting has reached
+
+  sgr_t sgr; ///< attributes in effect
+
+  /// a single SGR sequence establishing `sgr`, empty if it is the default
+  ///
+  /// Each attribute appears at most once, so this is bounded no matter how
+  /// many sequences the text contains.
+  char attr[96];
+  size_t attr_len; ///< number of bytes in `attr`
+} split_t;
+
+/// begin splitting text
+///
+/// \param me [out] Splitting state to initialise
+/// \param text Text to split
+/// \param len Number of bytes in `text`
+void split_init(split_t *me, const char *text, size_t len);
+
+/// find the next grapheme cluster that occupies at least one cell
+///
+/// \param me Splitting state
+/// \param cluster [out] Start of the cluster within the text
+/// \param len [out] Number of bytes in the cluster
+/// \param width [out] Number of columns the cluster occupies
+/// \return True if a cluster was found, false at the end of the text
+bool split_next(split_t *me, const char **cluster, size_t *len,
+                size_t *width);
+
+/// is a cluster just found displayed as an empty cell?
+///
+/// \param me Splitting state the cluster came from
+/// \param cluster Cluster returned from `split_next`
+/// \param len Number of bytes in `cluster`
+/// \return True if the cluster is a space with no attributes applied
+bool split_is_blank(const split_t *me, const char *cluster, size_t len);
+
+/// number of bytes needed to write a cluster along with its attributes
+///
+/// \param me Splitting state the cluster came from
+/// \param len Number of bytes in the cluster
+/// \return Number of bytes `split_encode` will write
+size_t split_encoded_len(const split_t *me, size_t len);
+
+/// write a cluster such that it can be displayed independently of its
+/// neighbours
+///
+/// The cluster is preceded by the escape sequences in effect and, if there are
+/// any, followed by a reset.
+///
+/// \param me Splitting state the cluster came from
+/// \param cluster Cluster returned from `split_next`
+/// \param len Number of bytes in `cluster`
+/// \param dst [out] Storage for `split_encoded_len` bytes
+void split_encode(const split_t *me, const char *cluster, size_t len,
+                  char *dst);
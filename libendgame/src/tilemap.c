@@ -0,0 +1,221 @@
+#include "tilemap.h"
+#include "form.h"
+#include "raster.h"
+#include <assert.h>
+#include <endgame/scene.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+int tilemap_new(tilemap_t **me, const char **palette) {
+  assert(me != NULL);
+  assert(palette != NULL);
+
+  *me = NULL;
+  tilemap_t *t = NULL;
+  int rc = 0;
+
+  t = calloc(1, sizeof(*t));
+  if (t == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  if ((rc = forms_new(&t->palette, &t->n_palette, palette)))
+    goto done;
+
+  // tiles must be able to index every form
+  if (t->n_palette > (eg_tile_t)-1) {
+    rc = ERANGE;
+    goto done;
+  }
+
+  *me = t;
+  t = NULL;
+
+done:
+  tilemap_free(t);
+
+  return rc;
+}
+
+/// floor division by `CHUNK_SIZE`
+static int64_t chunk_of(int64_t v) {
+  if (v >= 0)
+    return v / CHUNK_SIZE;
+  return -(-(v + 1) / CHUNK_SIZE) - 1;
+}
+
+static size_t hash(int64_t x, int64_t y) {
+  const uint64_t h = (uint64_t)x * UINT64_C(0x9e3779b97f4a7c15) ^
+                     (uint64_t)y * UINT64_C(0xc2b2ae3d27d4eb4f);
+  return (size_t)(h ^ (h >> 32));
+}
+
+/// find the slot a chunk does or would occupy
+static size_t slot(const tilemap_t *me, int64_t x, int64_t y) {
+  assert(me != NULL);
+  assert(me->c_chunks > 0);
+
+  const size_t mask = me->c_chunks - 1;
+  for (size_t i = hash(x, y) & mask;; i = (i + 1) & mask) {
+    const chunk_t *const c = me->chunks[i];
+    if (c == NULL || (c->x == x && c->y == y))
+      return i;
+  }
+}
+
+/// find an existing chunk
+static const chunk_t *find(const tilemap_t *me, int64_t x, int64_t y) {
+  assert(me != NULL);
+
+  if (me->c_chunks == 0)
+    return NULL;
+
+  return me->chunks[slot(me, x, y)];
+}
+
+/// expand the chunk table
+static int grow(tilemap_t *me) {
+  assert(me != NULL);
+
+  const size_t c = me->c_chunks == 0 ? 64 : me->c_chunks * 2;
+  chunk_t **const cs = calloc(c, sizeof(cs[0]));
+  if (cs == NULL)
+    return ENOMEM;
+
+  chunk_t **const old = me->chunks;
+  const size_t old_c = me->c_chunks;
+  me->chunks = cs;
+  me->c_chunks = c;
+
+  for (size_t i = 0; i < old_c; ++i) {
+    if (old[i] != NULL)
+      me->chunks[slot(me, old[i]->x, old[i]->y)] = old[i];
+  }
+  free(old);
+
+  return 0;
+}
+
+int tilemap_set(tilemap_t *me, int64_t x, int64_t y, eg_tile_t tile) {
+  assert(me != NULL);
+
+  if (tile > me->n_palette)
+    return ERANGE;
+
+  const int64_t cx = chunk_of(x);
+  const int64_t cy = chunk_of(y);
+  const size_t tx = (size_t)(x - cx * CHUNK_SIZE);
+  const size_t ty = (size_t)(y - cy * CHUNK_SIZE);
+
+  // clearing a tile in an unallocated chunk is a no-op
+  if (tile == 0 && find(me, cx, cy) == NULL)
+    return 0;
+
+  // keep the table at most half full
+  if ((me->n_chunks + 1) * 2 > me->c_chunks) {
+    const int rc = grow(me);
+    if (rc != 0)
+      return rc;
+  }
+
+  const size_t i = slot(me, cx, cy);
+  if (me->chunks[i] == NULL) {
+    chunk_t *const c = calloc(1, sizeof(*c));
+    if (c == NULL)
+      return ENOMEM;
+    c->x = cx;
+    c->y = cy;
+    me->chunks[i] = c;
+    ++me->n_chunks;
+  }
+
+  me->chunks[i]->tiles[ty * CHUNK_SIZE + tx] = tile;
+
+  if (tile != 0) {
+    const size_t width = me->palette[tile - 1].width;
+    const int64_t extent = width > 1 ? (int64_t)width - 1 : 0;
+    if (!me->any || x < me->left)
+      me->left = x;
+    if (!me->any || x + extent > me->right)
+      me->right = x + extent;
+    if (!me->any || y < me->top)
+      me->top = y;
+    if (!me->any || y > me->bottom)
+      me->bottom = y;
+    me->any = true;
+  }
+
+  return 0;
+}
+
+eg_tile_t tilemap_get(const tilemap_t *me, int64_t x, int64_t y) {
+  assert(me != NULL);
+
+  const int64_t cx = chunk_of(x);
+  const int64_t cy = chunk_of(y);
+
+  const chunk_t *const c = find(me, cx, cy);
+  if (c == NULL)
+    return 0;
+
+  const size_t tx = (size_t)(x - cx * CHUNK_SIZE);
+  const size_t ty = (size_t)(y - cy * CHUNK_SIZE);
+  return c->tiles[ty * CHUNK_SIZE + tx];
+}
+
+void tilemap_rasterise(const tilemap_t *me, cell_t *cells, size_t columns,
+                       size_t rows, eg_2D_t origin) {
+  assert(me != NULL);
+  assert(cells != NULL || rows * columns == 0);
+
+  for (size_t row = 0; row < rows; ++row) {
+    const int64_t y = origin.y + (int64_t)row;
+    const int64_t cy = chunk_of(y);
+    const size_t ty = (size_t)(y - cy * CHUNK_SIZE);
+    cell_t *const r = &cells[row * columns];
+
+    // first column not hidden beneath a wide tile
+    size_t uncovered = 0;
+
+    // walk the row a chunk at a time, so we only look up each chunk once
+    for (size_t col = 0; col < columns;) {
+      const int64_t x = origin.x + (int64_t)col;
+      const int64_t cx = chunk_of(x);
+      const size_t tx = (size_t)(x - cx * CHUNK_SIZE);
+      size_t span = CHUNK_SIZE - tx;
+      if (span > columns - col)
+        span = columns - col;
+
+      const chunk_t *const c = find(me, cx, cy);
+      if (c != NULL) {
+        const eg_tile_t *const tiles = &c->tiles[ty * CHUNK_SIZE + tx];
+        for (size_t i = 0; i < span; ++i) {
+          if (tiles[i] == 0 || col + i < uncovered)
+            continue;
+          uncovered = col + i + raster_put(r, columns, col + i,
+                                           &me->palette[tiles[i] - 1]);
+        }
+      }
+
+      col += span;
+    }
+  }
+}
+
+void tilemap_free(tilemap_t *me) {
+
+  if (me == NULL)
+    return;
+
+  for (size_t i = 0; i < me->c_chunks; ++i)
+    free(me->chunks[i]);
+  free(me->chunks);
+
+  forms_free(me->palette, me->n_palette);
+
+  free(me);
+}
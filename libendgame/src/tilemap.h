@@ -0,0 +1,79 @@
+#pragma once
+
+#include "form.h"
+#include "raster.h"
+#include <endgame/scene.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// width and height of a tilemap chunk, in tiles
+#define CHUNK_SIZE 64
+
+/// a square region of a tilemap
+typedef struct {
+  int64_t x; ///< X coordinate of the chunk, in units of `CHUNK_SIZE` tiles
+  int64_t y; ///< Y coordinate of the chunk, in units of `CHUNK_SIZE` tiles
+  eg_tile_t tiles[CHUNK_SIZE * CHUNK_SIZE]; ///< row-major tiles
+} chunk_t;
+
+struct layer;
+
+/// a dense grid of tiles, as it exists within a scene
+typedef struct {
+  form_t *palette;  ///< forms tiles can take, tile `n` being `palette[n - 1]`
+  size_t n_palette; ///< count of `palette`
+
+  /// allocated chunks, as an open addressed hash table keyed by position
+  chunk_t **chunks;
+  size_t n_chunks; ///< number of non-null entries in `chunks`
+  size_t c_chunks; ///< size of `chunks`, always a power of 2
+
+  /// bounding box of every tile that has ever been set
+  bool any; ///< have any tiles been set?
+  int64_t left;
+  int64_t right; ///< includes the extent of wide tiles
+  int64_t top;
+  int64_t bottom;
+
+  struct layer *layer; ///< layer of the scene this tilemap belongs to
+} tilemap_t;
+
+/// create a tilemap
+///
+/// \param me [out] Created tilemap on success
+/// \param palette Null-terminated list of forms tiles can take
+/// \return 0 on success or an errno on failure
+int tilemap_new(tilemap_t **me, const char **palette);
+
+/// set a tile
+///
+/// \param me Tilemap to operate on
+/// \param x X position of the tile
+/// \param y Y position of the tile
+/// \param tile Tile to set, 0 for none
+/// \return 0 on success or an errno on failure
+int tilemap_set(tilemap_t *me, int64_t x, int64_t y, eg_tile_t tile);
+
+/// get a tile
+///
+/// \param me Tilemap to read from
+/// \param x X position of the tile
+/// \param y Y position of the tile
+/// \return The tile at the given position, 0 for none
+eg_tile_t tilemap_get(const tilemap_t *me, int64_t x, int64_t y);
+
+/// rasterise a tilemap onto a grid of cells
+///
+/// \param me Tilemap to rasterise
+/// \param cells Grid of `rows` × `columns` cells to draw onto
+/// \param columns Width of `cells`
+/// \param rows Height of `cells`
+/// \param origin Scene coordinates of the top left of `cells`
+void tilemap_rasterise(const tilemap_t *me, cell_t *cells, size_t columns,
+                       size_t rows, eg_2D_t origin);
+
+/// destroy a tilemap
+///
+/// \param me Tilemap to destroy
+void tilemap_free(tilemap_t *me);
@@ -0,0 +1,288 @@
+#include "timer.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/// number of bits of time covered by a slot of a given level
+static unsigned span(size_t level) { return 6 * (unsigned)level; }
+
+static timer_entry_t *get(timers_t *me, uint32_t index) {
+  assert(me != NULL);
+  assert(index > 0 && index <= me->n_entries);
+  return &me->entries[index - 1];
+}
+
+/// append an entry to the end of a list
+static void push(timers_t *me, uint32_t index, size_t list) {
+  assert(me != NULL);
+  assert(list <= TIMER_FREE);
+
+  timer_entry_t *const e = get(me, index);
+  e->list = (uint16_t)list;
+  e->prev = me->tails[list];
+  e->next = 0;
+  if (me->tails[list] == 0) {
+    me->heads[list] = index;
+  } else {
+    get(me, me->tails[list])->next = index;
+  }
+  me->tails[list] = index;
+
+  if (list < TIMER_EXPIRED) {
+    me->occupied[list / TIMER_SLOTS] |= UINT64_C(1) << (list % TIMER_SLOTS);
+    ++me->pending;
+  }
+}
+
+/// remove an entry from whichever list it is on
+static void detach(timers_t *me, uint32_t index) {
+  assert(me != NULL);
+
+  timer_entry_t *const e = get(me, index);
+  const size_t list = e->list;
+
+  if (e->prev == 0) {
+    me->heads[list] = e->next;
+  } else {
+    get(me, e->prev)->next = e->next;
+  }
+  if (e->next == 0) {
+    me->tails[list] = e->prev;
+  } else {
+    get(me, e->next)->prev = e->prev;
+  }
+  e->prev = e->next = 0;
+
+  if (list < TIMER_EXPIRED) {
+    if (me->heads[list] == 0)
+      me->occupied[list / TIMER_SLOTS] &=
+          ~(UINT64_C(1) << (list % TIMER_SLOTS));
+    assert(me->pending > 0);
+    --me->pending;
+  }
+}
+
+/// place a timer into the slot for its expiry, or the expired list
+static void file(timers_t *me, uint32_t index) {
+  assert(me != NULL);
+
+  const uint64_t due = get(me, index)->due;
+
+  if (due <= me->now) {
+    push(me, index, TIMER_EXPIRED);
+    return;
+  }
+
+  // find the lowest level where the timer falls within the current rotation,
+  // defaulting to the top level for a timer a full rotation or more away
+  size_t level = 0;
+  while (level + 1 < TIMER_LEVELS &&
+         (due >> span(level + 1)) != (me->now >> span(level + 1)))
+    ++level;
+
+  const size_t slot = (due >> span(level)) % TIMER_SLOTS;
+  push(me, index, level * TIMER_SLOTS + slot);
+}
+
+/// find the start of the earliest non-empty slot
+///
+/// \param me Wheel to examine
+/// \param t [out] Start of the slot
+/// \return True if any slot is non-empty
+static bool earliest(const timers_t *me, uint64_t *t) {
+  assert(me != NULL);
+  assert(t != NULL);
+
+  // Every timer in a level expires after every timer in the levels below it,
+  // so the lowest non-empty level holds the earliest timer.
+  size_t level = 0;
+  while (level < TIMER_LEVELS && me->occupied[level] == 0)
+    ++level;
+  if (level == TIMER_LEVELS)
+    return false;
+
+  // below the top level, occupied slots all lie ahead of the current time
+  // within this rotation
+  if (level + 1 < TIMER_LEVELS) {
+    const unsigned rotation = span(level + 1);
+    const uint64_t slot = (uint64_t)__builtin_ctzll(me->occupied[level]);
+    *t = ((me->now >> rotation) << rotation) | (slot << span(level));
+    return true;
+  }
+
+  // at the top level, a slot at or behind the current one is for the next
+  // rotation
+  const unsigned rotation = span(TIMER_LEVELS);
+  bool found = false;
+  for (uint64_t bits = me->occupied[level]; bits != 0; bits &= bits - 1) {
+    const uint64_t slot = (uint64_t)__builtin_ctzll(bits);
+    uint64_t start =
+        ((me->now >> rotation) << rotation) | (slot << span(level));
+    if (start <= me->now)
+      start += UINT64_C(1) << rotation;
+    if (!found || start < *t)
+      *t = start;
+    found = true;
+  }
+  return found;
+}
+
+/// refile every timer in a slot
+static void cascade(timers_t *me, size_t list) {
+  assert(me != NULL);
+  assert(list < TIMER_EXPIRED);
+
+  while (me->heads[list] != 0) {
+    const uint32_t index = me->heads[list];
+    detach(me, index);
+    file(me, index);
+  }
+}
+
+void timers_advance(timers_t *me, uint64_t now) {
+  assert(me != NULL);
+
+  while (me->now < now) {
+
+    // skip straight to the next slot with anything in it
+    uint64_t t;
+    if (!earliest(me, &t) || t > now) {
+      me->now = now;
+      return;
+    }
+    assert(t > me->now);
+    me->now = t;
+
+    // refile any higher level slots beginning now, from the top down so their
+    // timers trickle through each level
+    size_t top = 1;
+    while (top < TIMER_LEVELS &&
+           (t & ((UINT64_C(1) << span(top)) - 1)) == 0)
+      ++top;
+    for (size_t level = top - 1; level > 0; --level) {
+      const size_t slot = (t >> span(level)) % TIMER_SLOTS;
+      cascade(me, level * TIMER_SLOTS + slot);
+    }
+
+    // everything in the current millisecond’s slot has now expired
+    const size_t list = t % TIMER_SLOTS;
+    while (me->heads[list] != 0) {
+      const uint32_t index = me->heads[list];
+      detach(me, index);
+      push(me, index, TIMER_EXPIRED);
+    }
+  }
+}
+
+int timers_add(timers_t *me, uint32_t delay, uint32_t period, uint32_t tag,
+               uint64_t *handle) {
+  assert(me != NULL);
+  assert(handle != NULL);
+
+  // reuse an unused entry, or make a new one
+  uint32_t index = me->heads[TIMER_FREE];
+  if (index != 0) {
+    detach(me, index);
+  } else {
+    if (me->n_entries == UINT32_MAX)
+      return ENOMEM;
+    if (me->n_entries == me->c_entries) {
+      const uint32_t c = me->c_entries == 0 ? 64
+                         : me->c_entries > UINT32_MAX / 2
+                             ? UINT32_MAX
+                             : me->c_entries * 2;
+      timer_entry_t *const es = realloc(me->entries, c * sizeof(es[0]));
+      if (es == NULL)
+        return ENOMEM;
+      me->entries = es;
+      me->c_entries = c;
+    }
+    me->entries[me->n_entries] = (timer_entry_t){0};
+    index = ++me->n_entries;
+  }
+
+  timer_entry_t *const e = get(me, index);
+  e->due = me->now + delay;
+  e->period = period;
+  e->tag = tag;
+  file(me, index);
+
+  *handle = ((uint64_t)e->generation << 32) | index;
+
+  return 0;
+}
+
+/// return an entry to the free list, invalidating handles to it
+static void release(timers_t *me, uint32_t index) {
+  assert(me != NULL);
+
+  ++get(me, index)->generation;
+  push(me, index, TIMER_FREE);
+}
+
+int timers_cancel(timers_t *me, uint64_t handle) {
+  assert(me != NULL);
+
+  const uint32_t index = (uint32_t)handle;
+  const uint32_t generation = (uint32_t)(handle >> 32);
+
+  if (index == 0 || index > me->n_entries)
+    return ENOENT;
+
+  const timer_entry_t *const e = get(me, index);
+  if (e->generation != generation || e->list == TIMER_FREE)
+    return ENOENT;
+
+  detach(me, index);
+  release(me, index);
+
+  return 0;
+}
+
+bool timers_pop(timers_t *me, uint32_t *tag) {
+  assert(me != NULL);
+  assert(tag != NULL);
+
+  const uint32_t index = me->heads[TIMER_EXPIRED];
+  if (index == 0)
+    return false;
+
+  detach(me, index);
+  timer_entry_t *const e = get(me, index);
+  *tag = e->tag;
+
+  if (e->period == 0) {
+    release(me, index);
+    return true;
+  }
+
+  // schedule the next expiry after now, in phase with the previous ones
+  assert(e->due <= me->now);
+  const uint64_t missed = (me->now - e->due) / e->period;
+  e->due += (missed + 1) * e->period;
+  file(me, index);
+
+  return true;
+}
+
+bool timers_next(const timers_t *me, uint64_t *due) {
+  assert(me != NULL);
+  assert(due != NULL);
+
+  if (me->heads[TIMER_EXPIRED] != 0) {
+    *due = me->now;
+    return true;
+  }
+
+  return earliest(me, due);
+}
+
+void timers_free(timers_t *me) {
+  assert(me != NULL);
+
+  free(me->entries);
+  *me = (timers_t){0};
+}
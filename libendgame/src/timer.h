@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// number of levels in a timer wheel
+///
+/// Each level has 64 slots, each covering 64 times the span of a slot in the
+/// level below, starting from 1ms. So 6 levels span 2³⁶ms, more than any delay
+/// that can be scheduled.
+enum { TIMER_LEVELS = 6 };
+
+/// number of slots in each level of a timer wheel
+enum { TIMER_SLOTS = 64 };
+
+/// index of the list of timers that have expired but not yet been delivered
+enum { TIMER_EXPIRED = TIMER_LEVELS * TIMER_SLOTS };
+
+/// index of the list of unused entries
+enum { TIMER_FREE = TIMER_EXPIRED + 1 };
+
+/// a scheduled timer
+typedef struct {
+  uint64_t due;        ///< time at which this timer next expires, in ms
+  uint32_t period;     ///< interval at which this timer repeats, 0 if one-shot
+  uint32_t tag;        ///< caller’s identification of this timer
+  uint32_t generation; ///< count of times this entry has been reused
+
+  /// neighbours within the list this entry is on, as 1-based indices into
+  /// `timers_t.entries`, 0 for none
+  uint32_t prev;
+  uint32_t next;
+
+  uint16_t list; ///< which list this entry is on
+} timer_entry_t;
+
+/// a hierarchical timer wheel
+///
+/// A timer is filed in the lowest level whose slots are narrow enough to tell
+/// its expiry apart from the current time. As time reaches each slot of a
+/// higher level, the timers within it are refiled into lower levels, until they
+/// reach level 0 where each slot is a single millisecond. So scheduling,
+/// cancelling and expiring a timer are all constant time, regardless of how
+/// many timers are pending.
+///
+/// Entries are referred to by index rather than address, so the entry array
+/// can grow without invalidating lists. A zeroed `timers_t` is empty.
+typedef struct {
+  timer_entry_t *entries; ///< all timers, live or unused
+  uint32_t n_entries;     ///< number of entries in use or on the free list
+  uint32_t c_entries;     ///< number of entries allocated
+
+  /// heads and tails of each slot’s list, followed by the expired and free
+  /// lists, as 1-based indices into `entries`
+  uint32_t heads[TIMER_FREE + 1];
+  uint32_t tails[TIMER_FREE + 1];
+
+  uint64_t occupied[TIMER_LEVELS]; ///< which slots of each level are non-empty
+  size_t pending; ///< number of timers filed in the wheel, excluding expired
+
+  uint64_t now; ///< time up to which timers have been expired, in ms
+} timers_t;
+
+/// schedule a timer
+///
+/// \param me Wheel to add to
+/// \param delay Milliseconds from `me->now` until the timer expires
+/// \param period Milliseconds between subsequent expiries, or 0 for one-shot
+/// \param tag Caller’s identification of this timer
+/// \param handle [out] Identifier of the scheduled timer, never 0
+/// \return 0 on success or an errno on failure
+int timers_add(timers_t *me, uint32_t delay, uint32_t period, uint32_t tag,
+               uint64_t *handle);
+
+/// unschedule a timer
+///
+/// \param me Wheel the timer was added to
+/// \param handle Identifier returned from `timers_add`
+/// \return 0 on success, or `ENOENT` if the timer has already been delivered
+///   for the last time or cancelled
+int timers_cancel(timers_t *me, uint64_t handle);
+
+/// move time forwards, expiring any timers due by then
+///
+/// \param me Wheel to advance
+/// \param now Current time in ms, which is ignored if it is in the past
+void timers_advance(timers_t *me, uint64_t now);
+
+/// take the next expired timer
+///
+/// A periodic timer is rescheduled for its next expiry after the current time.
+/// If it has missed several, they are delivered as one.
+///
+/// \param me Wheel to take from
+/// \param tag [out] Tag of the expired timer
+/// \return True if a timer had expired
+bool timers_pop(timers_t *me, uint32_t *tag);
+
+/// find when the next timer will expire
+///
+/// The time given may be earlier than the true expiry, in which case
+/// advancing to it will expire nothing and a later call will give a more
+/// accurate time.
+///
+/// \param me Wheel to examine
+/// \param due [out] Time at or before which the next timer expires
+/// \return True if there are any timers, expired or pending
+bool timers_next(const timers_t *me, uint64_t *due);
+
+/// deallocate the backing memory of a timer wheel
+void timers_free(timers_t *me);
@@ -0,0 +1,231 @@
+#include "viewport.h"
+#include "form.h"
+#include "frame.h"
+#include "io.h"
+#include "raster.h"
+#include "scene.h"
+#include <assert.h>
+#include <endgame/io.h>
+#include <endgame/scene.h>
+#include <endgame/viewport.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int eg_viewport_new(eg_viewport_t **me, eg_scene_t *scene, eg_io_t *io,
+                    size_t x, size_t y, size_t columns, size_t rows) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (scene == NULL)
+    return EINVAL;
+
+  if (io == NULL)
+    return EINVAL;
+
+  if (columns > 0 && rows > SIZE_MAX / columns / sizeof(cell_t))
+    return EOVERFLOW;
+
+  *me = NULL;
+  eg_viewport_t *v = NULL;
+  int rc = 0;
+
+  v = calloc(1, sizeof(*v));
+  if (v == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  v->scene = scene;
+  v->io = io;
+  v->x = x;
+  v->y = y;
+  v->columns = columns;
+  v->rows = rows;
+
+  // allocate at least one element so a degenerate viewport is not mistaken for
+  // an allocation failure
+  v->raster = calloc(rows * columns + 1, sizeof(v->raster[0]));
+  v->scratch = calloc(rows * columns + 1, sizeof(v->scratch[0]));
+  v->dirty = calloc(rows + 1, sizeof(v->dirty[0]));
+  if (v->raster == NULL || v->scratch == NULL || v->dirty == NULL) {
+    rc = ENOMEM;
+    goto done;
+  }
+
+  *me = v;
+  v = NULL;
+
+done:
+  eg_viewport_free(&v);
+
+  return rc;
+}
+
+int eg_viewport_set_origin(eg_viewport_t *me, eg_2D_t origin) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  if (origin.x != me->origin.x || origin.y != me->origin.y) {
+    me->origin = origin;
+    me->moved = true;
+  }
+
+  return 0;
+}
+
+/// determine which rows of a viewport need recompositing
+///
+/// \param me Viewport to examine
+/// \return True if any rows are dirty
+static bool find_dirty(eg_viewport_t *me) {
+  assert(me != NULL);
+
+  const eg_scene_t *const s = me->scene;
+
+  // if we have lost track of what changed, start from scratch
+  if (!me->valid || me->moved ||
+      s->generation - me->generation >= DAMAGE_RING) {
+    for (size_t i = 0; i < me->rows; ++i)
+      me->dirty[i] = true;
+    return me->rows > 0;
+  }
+
+  memset(me->dirty, 0, me->rows * sizeof(me->dirty[0]));
+  if (me->columns == 0 || me->rows == 0)
+    return false;
+
+  const int64_t left = me->origin.x;
+  const int64_t right = me->origin.x + (int64_t)me->columns - 1;
+  const int64_t top = me->origin.y;
+  const int64_t bottom = me->origin.y + (int64_t)me->rows - 1;
+
+  bool any = false;
+  for (uint64_t g = me->generation + 1; g <= s->generation; ++g) {
+    const rect_t *const r = &s->damage[g % DAMAGE_RING];
+
+    // skip modifications outside our view
+    if (r->right < left || r->left > right)
+      continue;
+    if (r->bottom < top || r->top > bottom)
+      continue;
+
+    const int64_t from = r->top > top ? r->top : top;
+    const int64_t to = r->bottom < bottom ? r->bottom : bottom;
+    for (int64_t y = from; y <= to; ++y)
+      me->dirty[y - top] = true;
+    any = true;
+  }
+
+  return any;
+}
+
+int eg_viewport_paint(eg_viewport_t *me) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  eg_scene_sync(me->scene);
+
+  const bool any = find_dirty(me);
+
+  // If forms have been freed since the last paint, `raster` may name a form
+  // whose address now belongs to a different one. The removals damaged every
+  // cell displaying them, so rewriting all cells of the dirty rows purges them.
+  const bool trusted = me->valid && me->epoch == me->scene->epoch;
+
+  // whether we repaint or not, we are now up to date with the scene
+  me->generation = me->scene->generation;
+  me->epoch = me->scene->epoch;
+  me->moved = false;
+
+  if (!any) {
+    me->valid = true;
+    return 0;
+  }
+
+  const size_t columns = me->columns;
+  encoded_t blank = {.width = 1};
+
+  for (size_t begin = 0; begin < me->rows;) {
+
+    // find the next run of dirty rows
+    if (!me->dirty[begin]) {
+      ++begin;
+      continue;
+    }
+    size_t end = begin + 1;
+    while (end < me->rows && me->dirty[end])
+      ++end;
+
+    const eg_2D_t origin = {.x = me->origin.x,
+                            .y = me->origin.y + (int64_t)begin};
+    scene_compose(me->scene, &me->scratch[begin * columns], columns,
+                  end - begin, origin);
+
+    // write out only what changed
+    for (size_t row = begin; row < end; ++row) {
+      for (size_t col = 0; col < columns; ++col) {
+        const cell_t c = me->scratch[row * columns + col];
+
+        // skip cells displayed by the wide form to their left
+        if (c == COVERED)
+          continue;
+
+        if (trusted && c == me->raster[row * columns + col])
+          continue;
+
+        const size_t x = me->x + col;
+        const size_t y = me->y + row;
+        const int rc = c == NULL
+                           ? io_put_encoded(me->io, x, y, &blank, 1)
+                           : io_put_encoded(me->io, x, y, c->cells, c->n_cells);
+        if (rc != 0) {
+          // we no longer know what is displayed
+          me->valid = false;
+          return rc;
+        }
+      }
+    }
+
+    memcpy(&me->raster[begin * columns], &me->scratch[begin * columns],
+           (end - begin) * columns * sizeof(me->raster[0]));
+
+    begin = end;
+  }
+
+  me->valid = true;
+
+  return 0;
+}
+
+int eg_viewport_invalidate(eg_viewport_t *me) {
+
+  if (me == NULL)
+    return EINVAL;
+
+  me->valid = false;
+
+  return 0;
+}
+
+void eg_viewport_free(eg_viewport_t **me) {
+
+  if (me == NULL)
+    return;
+
+  if (*me == NULL)
+    return;
+
+  free((*me)->dirty);
+  free((*me)->scratch);
+  free((*me)->raster);
+
+  free(*me);
+  *me = NULL;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "raster.h"
+#include <endgame/io.h>
+#include <endgame/scene.h>
+#include <endgame/viewport.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct eg_viewport {
+  eg_scene_t *scene; ///< scene being displayed
+  eg_io_t *io;       ///< device being drawn onto
+
+  size_t x;       ///< column of `io` at the left edge, 1-based
+  size_t y;       ///< row of `io` at the top edge, 1-based
+  size_t columns; ///< width
+  size_t rows;    ///< height
+  eg_2D_t origin; ///< scene coordinates of the top left cell
+
+  cell_t *raster;  ///< `rows` × `columns` cells last displayed
+  cell_t *scratch; ///< `rows` × `columns` cells of space for compositing
+  bool *dirty;     ///< `rows` flags of which rows need recompositing
+
+  bool valid;          ///< does `raster` reflect what is displayed?
+  bool moved;          ///< has `origin` changed since the last paint?
+  uint64_t generation; ///< scene generation `raster` reflects
+  uint64_t epoch;      ///< scene epoch the forms in `raster` belong to
+};
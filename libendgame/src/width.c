@@ -0,0 +1,256 @@
+#include "width.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// an inclusive range of Unicode code points
+typedef struct {
+  uint32_t lo;
+  uint32_t hi;
+} range_t;
+
+/// code points that occupy no columns of their own
+///
+/// These are combining marks, joiners, variation selectors, and similar
+/// characters that modify the preceding base character.
+static const range_t ZERO[] = {
+    {0x0300, 0x036f},   {0x0483, 0x0489},   {0x0591, 0x05bd},
+    {0x05bf, 0x05bf},   {0x05c1, 0x05c2},   {0x05c4, 0x05c5},
+    {0x05c7, 0x05c7},   {0x0610, 0x061a},   {0x064b, 0x065f},
+    {0x0670, 0x0670},   {0x06d6, 0x06dc},   {0x06df, 0x06e4},
+    {0x06e7, 0x06e8},   {0x06ea, 0x06ed},   {0x0e31, 0x0e31},
+    {0x0e34, 0x0e3a},   {0x0e47, 0x0e4e},   {0x1ab0, 0x1aff},
+    {0x1dc0, 0x1dff},   {0x200b, 0x200f},   {0x2028, 0x202e},
+    {0x2060, 0x2064},   {0x20d0, 0x20ff},   {0xfe00, 0xfe0f},
+    {0xfe20, 0xfe2f},   {0xfeff, 0xfeff},   {0x1f3fb, 0x1f3ff},
+    {0xe0000, 0xe007f}, {0xe0100, 0xe01ef},
+};
+
+/// code points with an East Asian Width of Wide or Fullwidth
+static const range_t WIDE[] = {
+    {0x1100, 0x115f},   {0x231a, 0x231b},   {0x2329, 0x232a},
+    {0x23e9, 0x23ec},   {0x23f0, 0x23f0},   {0x23f3, 0x23f3},
+    {0x25fd, 0x25fe},   {0x2614, 0x2615},   {0x2648, 0x2653},
+    {0x267f, 0x267f},   {0x2693, 0x2693},   {0x26a1, 0x26a1},
+    {0x26aa, 0x26ab},   {0x26bd, 0x26be},   {0x26c4, 0x26c5},
+    {0x26ce, 0x26ce},   {0x26d4, 0x26d4},   {0x26ea, 0x26ea},
+    {0x26f2, 0x26f3},   {0x26f5, 0x26f5},   {0x26fa, 0x26fa},
+    {0x26fd, 0x26fd},   {0x2705, 0x2705},   {0x270a, 0x270b},
+    {0x2728, 0x2728},   {0x274c, 0x274c},   {0x274e, 0x274e},
+    {0x2753, 0x2755},   {0x2757, 0x2757},   {0x2795, 0x2797},
+    {0x27b0, 0x27b0},   {0x27bf, 0x27bf},   {0x2b1b, 0x2b1c},
+    {0x2b50, 0x2b50},   {0x2b55, 0x2b55},   {0x2e80, 0x303e},
+    {0x3041, 0x33ff},   {0x3400, 0x4dbf},   {0x4e00, 0x9fff},
+    {0xa000, 0xa4cf},   {0xa960, 0xa97f},   {0xac00, 0xd7a3},
+    {0xf900, 0xfaff},   {0xfe10, 0xfe19},   {0xfe30, 0xfe6f},
+    {0xff00, 0xff60},   {0xffe0, 0xffe6},   {0x16fe0, 0x16fe4},
+    {0x17000, 0x18aff}, {0x1b000, 0x1b2ff}, {0x1f004, 0x1f004},
+    {0x1f0cf, 0x1f0cf}, {0x1f18e, 0x1f18e}, {0x1f191, 0x1f19a},
+    {0x1f200, 0x1f202}, {0x1f210, 0x1f23b}, {0x1f240, 0x1f248},
+    {0x1f250, 0x1f251}, {0x1f260, 0x1f265}, {0x1f300, 0x1f320},
+    {0x1f32d, 0x1f335}, {0x1f337, 0x1f37c}, {0x1f37e, 0x1f393},
+    {0x1f3a0, 0x1f3ca}, {0x1f3cf, 0x1f3d3}, {0x1f3e0, 0x1f3f0},
+    {0x1f3f4, 0x1f3f4}, {0x1f3f8, 0x1f43e}, {0x1f440, 0x1f440},
+    {0x1f442, 0x1f4fc}, {0x1f4ff, 0x1f53d}, {0x1f54b, 0x1f54e},
+    {0x1f550, 0x1f567}, {0x1f57a, 0x1f57a}, {0x1f595, 0x1f596},
+    {0x1f5a4, 0x1f5a4}, {0x1f5fb, 0x1f64f}, {0x1f680, 0x1f6c5},
+    {0x1f6cc, 0x1f6cc}, {0x1f6d0, 0x1f6d2}, {0x1f6d5, 0x1f6d7},
+    {0x1f6dc, 0x1f6df}, {0x1f6eb, 0x1f6ec}, {0x1f6f4, 0x1f6fc},
+    {0x1f7e0, 0x1f7eb}, {0x1f7f0, 0x1f7f0}, {0x1f90c, 0x1f93a},
+    {0x1f93c, 0x1f945}, {0x1f947, 0x1f9ff}, {0x1fa70, 0x1faff},
+    {0x20000, 0x2fffd}, {0x30000, 0x3fffd},
+};
+
+/// is the given code point within one of the given (sorted) ranges?
+static bool in(uint32_t c, const range_t *ranges, size_t n) {
+  assert(ranges != NULL);
+
+  if (c < ranges[0].lo || c > ranges[n - 1].hi)
+    return false;
+
+  size_t lo = 0;
+  size_t hi = n;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (c < ranges[mid].lo) {
+      hi = mid;
+    } else if (c > ranges[mid].hi) {
+      lo = mid + 1;
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// ZERO WIDTH JOINER
+static const uint32_t ZWJ = 0x200d;
+
+/// VARIATION SELECTOR-16, requesting emoji presentation
+static const uint32_t VS16 = 0xfe0f;
+
+/// is this a REGIONAL INDICATOR SYMBOL, half of a flag?
+static bool is_regional(uint32_t c) { return c >= 0x1f1e6 && c <= 0x1f1ff; }
+
+/// decode a single UTF-8 character
+///
+/// Malformed input is consumed one byte at a time and decoded as U+FFFD.
+///
+/// \param text Bytes to decode from
+/// \param len Number of available bytes in `text`
+/// \param c [out] Decoded code point
+/// \return Number of bytes consumed
+static size_t decode(const unsigned char *text, size_t len, uint32_t *c) {
+  assert(text != NULL);
+  assert(len > 0);
+  assert(c != NULL);
+
+  size_t more = 0;
+  if (text[0] < 0x80) {
+    *c = text[0];
+  } else if ((text[0] >> 5) == 6) {
+    *c = text[0] & 0x1f;
+    more = 1;
+  } else if ((text[0] >> 4) == 14) {
+    *c = text[0] & 0xf;
+    more = 2;
+  } else if ((text[0] >> 3) == 30) {
+    *c = text[0] & 0x7;
+    more = 3;
+  } else {
+    *c = 0xfffd;
+    return 1;
+  }
+
+  if (more >= len) {
+    *c = 0xfffd;
+    return 1;
+  }
+
+  for (size_t i = 1; i <= more; ++i) {
+    if ((text[i] >> 6) != 2) {
+      *c = 0xfffd;
+      return 1;
+    }
+    *c = (*c << 6) | (text[i] & 0x3f);
+  }
+
+  return more + 1;
+}
+
+size_t escape_length(const char *text, size_t len) {
+  assert(text != NULL);
+  assert(len > 0);
+  assert(text[0] == 0x1b);
+
+  const unsigned char *const t = (const unsigned char *)text;
+
+  if (len < 2)
+    return len;
+
+  // CSI: parameters and intermediates, terminated by a final byte
+  if (t[1] == '[') {
+    for (size_t i = 2; i < len; ++i) {
+      if (t[i] >= 0x40 && t[i] <= 0x7e)
+        return i + 1;
+    }
+    return len;
+  }
+
+  // OSC, DCS, APC, PM: a string terminated by BEL or ST
+  if (t[1] == ']' || t[1] == 'P' || t[1] == '_' || t[1] == '^') {
+    for (size_t i = 2; i < len; ++i) {
+      if (t[i] == 0x7)
+        return i + 1;
+      if (t[i] == 0x1b && i + 1 < len && t[i + 1] == '\\')
+        return i + 2;
+    }
+    return len;
+  }
+
+  // anything else is a two character sequence
+  return 2;
+}
+
+size_t next_cluster(const char *text, size_t len, size_t *width) {
+  assert(text != NULL);
+  assert(len > 0);
+  assert(text[0] != 0x1b);
+  assert(width != NULL);
+
+  const unsigned char *const t = (const unsigned char *)text;
+
+  // the base character determines the width of the cluster
+  uint32_t base;
+  size_t i = decode(t, len, &base);
+  if (base < 0x20 || (base >= 0x7f && base < 0xa0) ||
+      in(base, ZERO, sizeof(ZERO) / sizeof(ZERO[0]))) {
+    *width = 0;
+  } else if (is_regional(base) ||
+             in(base, WIDE, sizeof(WIDE) / sizeof(WIDE[0]))) {
+    *width = 2;
+  } else {
+    *width = 1;
+  }
+
+  // the second half of a flag joins the first
+  bool regional = is_regional(base);
+
+  // consume any following characters that extend the cluster
+  while (i < len && t[i] != 0x1b) {
+    uint32_t c;
+    const size_t n = decode(&t[i], len - i, &c);
+
+    if (c == ZWJ) {
+      i += n;
+      // the joined character is part of this cluster
+      if (i < len && t[i] != 0x1b)
+        i += decode(&t[i], len - i, &c);
+      continue;
+    }
+
+    // emoji presentation of a narrow base character widens it
+    if (c == VS16) {
+      if (*width == 1)
+        *width = 2;
+      i += n;
+      continue;
+    }
+
+    if (regional && is_regional(c)) {
+      regional = false;
+      i += n;
+      continue;
+    }
+
+    if (in(c, ZERO, sizeof(ZERO) / sizeof(ZERO[0]))) {
+      i += n;
+      continue;
+    }
+
+    break;
+  }
+
+  return i;
+}
+
+size_t display_width(const char *text, size_t len) {
+  assert(text != NULL || len == 0);
+
+  size_t width = 0;
+
+  for (size_t i = 0; i < len;) {
+
+    if (text[i] == 0x1b) {
+      i += escape_length(&text[i], len - i);
+      continue;
+    }
+
+    size_t w;
+    i += next_cluster(&text[i], len - i, &w);
+    width += w;
+  }
+
+  return width;
+}
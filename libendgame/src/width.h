@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+
+/// measure how many terminal columns some text occupies when displayed
+///
+/// Text is treated as a sequence of grapheme clusters. Each cluster is as wide
+/// as its base character according to its East Asian Width, with combining
+/// marks, zero-width joined characters, and similar extenders contributing
+/// nothing. Escape sequences (e.g. SGR attributes) are skipped.
+///
+/// This involves decoding UTF-8, so is intended to be called once when text is
+/// registered rather than each time it is displayed.
+///
+/// \param text UTF-8 text to measure
+/// \param len Number of bytes in `text`
+/// \return Number of columns `text` occupies
+size_t display_width(const char *text, size_t len);
+
+/// measure the length of an escape sequence
+///
+/// \param text Bytes beginning with an ESC
+/// \param len Number of available bytes in `text`
+/// \return Number of bytes in the escape sequence
+size_t escape_length(const char *text, size_t len);
+
+/// find the extent of the grapheme cluster at the start of some text
+///
+/// \param text UTF-8 text, not beginning with an escape sequence
+/// \param len Number of available bytes in `text`
+/// \param width [out] Number of columns the cluster occupies
+/// \return Number of bytes in the cluster
+size_t next_cluster(const char *text, size_t len, size_t *width);